@@ -0,0 +1,49 @@
+// Array fill, indexed reads & merge sort building new arrays
+
+var sort = function(a) {
+	var n = a.size();
+	if (n < 2)
+		return a;
+
+	var left  = [];
+	var right = [];
+	for (var i = 0; i < n; i++)
+		if (i < n / 2)
+			left.push(a[i]);
+		else
+			right.push(a[i]);
+
+	left  = sort(left);
+	right = sort(right);
+
+	var result = [];
+	var i      = 0;
+	var j      = 0;
+	while (i < left.size() && j < right.size())
+		if (right[j] < left[i])
+			result.push(right[j++]);
+		else
+			result.push(left[i++]);
+
+	while (i < left.size())
+		result.push(left[i++]);
+	while (j < right.size())
+		result.push(right[j++]);
+
+	return result;
+};
+
+var a    = [];
+var seed = 12345;
+for (var i = 0; i < 500; i++) {
+	seed = (seed * 1103515245 + 12345) & 2147483647;
+	a.push(seed % 100000);
+}
+
+a = sort(a);
+
+for (var i = 1; i < a.size(); i++)
+	if (a[i] < a[i - 1])
+		raise Error('not sorted at ' + i);
+
+stdio.println(a.size());
@@ -0,0 +1,30 @@
+// Line-by-line file processing with Scanner.
+// Requires Files module, built by compile.sh bench
+
+NativeLoader.load('../bin/StreamApi.so');
+NativeLoader.load('../bin/Files.so');
+
+var f = File('../bin/bench_lines.txt');
+if (f.exists() == false) {
+	f.createNewFile();
+	var p = Printer(f);
+	for (var i = 0; i < 2000; i++)
+		p.println('line ' + i + ' of the benchmark input');
+	p.close();
+}
+
+var total = 0;
+var lines = 0;
+for (var pass = 0; pass < 4; pass++) {
+	var s = Scanner(f);
+	while (s.eof() == false) {
+		var l = s.readLine();
+		if (l.length() > 0) {
+			total = total + l.length();
+			lines++;
+		}
+	}
+	s.close();
+}
+
+stdio.println('lines: ' + lines + ', chars: ' + total);
@@ -0,0 +1,18 @@
+// Short-lived garbage & long-lived retained graph
+
+var keep = [];
+for (var i = 0; i < 4000; i++) {
+	var node   = {};
+	node.value = i;
+	node.data  = [i, i + 1, 'n' + i];
+	if (i % 20 == 0)
+		keep.push(node);
+	else if (keep.size() > 0)
+		node.next = keep[keep.size() - 1];
+}
+
+var sum = 0;
+for (var i = 0; i < keep.size(); i++)
+	sum = sum + keep[i].value;
+
+stdio.println(sum);
@@ -0,0 +1,16 @@
+// Integer arithmetic in tight loops
+
+var sum = 0;
+for (var i = 0; i < 8000; i++) {
+	sum = sum + i * 3 % 7;
+	if (i & 1)
+		sum = sum - 1;
+	else
+		sum = sum ^ 5;
+}
+
+var k = 0;
+while (k < 4000)
+	k++;
+
+stdio.println(sum + k);
@@ -0,0 +1,19 @@
+// Property reads & writes, method calls on objects
+
+var point = function(x, y) {
+	var p = {x: x, y: y};
+	p.length = function() { return this.x * this.x + this.y * this.y; };
+	return p;
+};
+
+var total = 0;
+var o     = {a: 1, b: 2, c: 3, d: 4};
+for (var i = 0; i < 4000; i++) {
+	var p = point(i, i + 1);
+	p.x   = p.x + o.a;
+	p.y   = p.y - o.b;
+	o.c   = o.c + o.d;
+	total = total + p.length() % 1000;
+}
+
+stdio.println(total + o.c);
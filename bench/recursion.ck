@@ -0,0 +1,15 @@
+// Deep & wide recursive calls
+
+var fib = function(n) {
+	if (n < 2)
+		return n;
+	return fib(n - 1) + fib(n - 2);
+};
+
+var depth = function(n) {
+	if (n == 0)
+		return 0;
+	return 1 + depth(n - 1);
+};
+
+stdio.println(fib(20) + depth(2000));
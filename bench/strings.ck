@@ -0,0 +1,15 @@
+// String building & string methods
+
+var s = '';
+for (var i = 0; i < 5000; i++)
+	s = s + 'x' + i;
+
+var count = 0;
+for (var i = 0; i < 2000; i++) {
+	var t = 'item-' + i + '-value';
+	if (t.startsWith('item-') && t.endsWith('-value'))
+		count = count + t.indexOf('-value');
+	count = count + t.toUpperCase().length();
+}
+
+stdio.println(s.length() + count);
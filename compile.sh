@@ -13,12 +13,22 @@ if [ "$1" == "debug" ]; then
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/Context.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/TokenStream.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/Parser.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/ASTOptimizer.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/ASTCache.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/ImportPrefetch.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/Profiler.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/ASTCounters.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/Tracer.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/AllocProfiler.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/TypeFeedback.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/HeapSnapshot.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/string.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/TreeObjectMap.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/ASTExecuter.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/DebugUtils.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/TokenNamespace.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/Integer.cpp
+	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/BuiltinTable.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/Scope.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/Null.cpp
 	g++ -rdynamic -w -g -std=c++11 -fpermissive -c ../src/objects/Undefined.cpp
@@ -37,7 +47,8 @@ if [ "$1" == "debug" ]; then
 	
 	cd ../
 
-	g++ -rdynamic -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -o bin/ck
+	g++ -rdynamic -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/ASTOptimizer.o bin/ASTCache.o bin/ImportPrefetch.o bin/Profiler.o bin/ASTCounters.o bin/Tracer.o bin/AllocProfiler.o bin/TypeFeedback.o bin/HeapSnapshot.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/BuiltinTable.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -lpthread -o bin/ck
+	g++ -w -g -std=c++11 src/tools/heapdiff.cpp -o bin/heapdiff
 	
 	valgrind --track-origins=yes --leak-check=full --show-leak-kinds=all ./bin/ck -f res/in.ck 2> erroutput.txt
 elif [ "$1" == "install" ]; then
@@ -47,12 +58,22 @@ elif [ "$1" == "install" ]; then
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Context.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TokenStream.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Parser.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTOptimizer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTCache.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ImportPrefetch.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Profiler.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTCounters.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Tracer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/AllocProfiler.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TypeFeedback.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/HeapSnapshot.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/string.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/TreeObjectMap.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTExecuter.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/DebugUtils.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TokenNamespace.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Integer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/BuiltinTable.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Scope.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Null.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Undefined.cpp
@@ -71,8 +92,65 @@ elif [ "$1" == "install" ]; then
 	
 	cd ../
 
-	g++ -rdynamic -O -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -o bin/ck
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/ASTOptimizer.o bin/ASTCache.o bin/ImportPrefetch.o bin/Profiler.o bin/ASTCounters.o bin/Tracer.o bin/AllocProfiler.o bin/TypeFeedback.o bin/HeapSnapshot.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/BuiltinTable.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -lpthread -o bin/ck
+	g++ -O -w -g -std=c++11 src/tools/heapdiff.cpp -o bin/heapdiff
 	sudo cp bin/ck /usr/local/bin/ck
+elif [ "$1" == "bench" ]; then
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/exec_state.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/DefaultObjectDefineUtil.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/FileUrl.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/Context.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/TokenStream.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/Parser.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/ASTOptimizer.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/ASTCache.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/ImportPrefetch.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/Profiler.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/ASTCounters.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/Tracer.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/AllocProfiler.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/TypeFeedback.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/HeapSnapshot.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/string.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/TreeObjectMap.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/ASTExecuter.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/DebugUtils.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/TokenNamespace.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Integer.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/BuiltinTable.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Scope.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Null.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Undefined.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/NativeFunction.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/ObjectConverter.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Boolean.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/CodeFunction.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/StringType.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Double.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Object.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Array.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/VirtualObject.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/GarbageCollector.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/NativeLoaderType.cpp
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive -c ../src/objects/Error.cpp
+	
+	cd ../
+
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/ASTOptimizer.o bin/ASTCache.o bin/ImportPrefetch.o bin/Profiler.o bin/ASTCounters.o bin/Tracer.o bin/AllocProfiler.o bin/TypeFeedback.o bin/HeapSnapshot.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/BuiltinTable.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -lpthread -o bin/ck
+	g++ -O2 -w -std=c++11 src/tools/ckbench.cpp -o bin/ckbench
+	g++ -rdynamic -O2 -w -std=c++11 -fpermissive src/tools/microbench.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/ASTOptimizer.o bin/ASTCache.o bin/ImportPrefetch.o bin/Profiler.o bin/ASTCounters.o bin/Tracer.o bin/AllocProfiler.o bin/TypeFeedback.o bin/HeapSnapshot.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/BuiltinTable.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -lpthread -o bin/microbench
+	
+	# Files module for bench/file_lines.ck
+	g++ -static -w -c -fPIC -std=c++11 -fpermissive src/modules/StreamApi.cpp -o bin/StreamApi.o
+	gcc -shared -o bin/StreamApi.so bin/StreamApi.o
+	g++ -static -w -c -fPIC -std=c++11 -fpermissive src/modules/Files.cpp -o bin/Files.o
+	gcc -shared -o bin/Files.so bin/Files.o
+	
+	# Use: bash compile.sh bench [--runs=N] [--warmup=N]
+	shift
+	REV=`git rev-parse --short HEAD 2>/dev/null`
+	./bin/ckbench --ck=bin/ck --label=$REV --json=bin/bench-$REV.json "$@" bench/*.ck
+	./bin/microbench --json=bin/microbench-$REV.json
 elif [ "$1" == "clean" ]; then
 	rm *
 else
@@ -82,12 +160,22 @@ else
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Context.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TokenStream.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Parser.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTOptimizer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTCache.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ImportPrefetch.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Profiler.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTCounters.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/Tracer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/AllocProfiler.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TypeFeedback.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/HeapSnapshot.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/string.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/TreeObjectMap.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/ASTExecuter.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/DebugUtils.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/TokenNamespace.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Integer.cpp
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/BuiltinTable.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Scope.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Null.cpp
 	g++ -rdynamic -O -w -g -std=c++11 -fpermissive -c ../src/objects/Undefined.cpp
@@ -106,7 +194,8 @@ else
 	
 	cd ../
 
-	g++ -rdynamic -O -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -o bin/ck
+	g++ -rdynamic -O -w -g -std=c++11 -fpermissive src/ck.cpp bin/exec_state.o bin/DefaultObjectDefineUtil.o bin/FileUrl.o bin/Context.o bin/TokenStream.o bin/Parser.o bin/ASTOptimizer.o bin/ASTCache.o bin/ImportPrefetch.o bin/Profiler.o bin/ASTCounters.o bin/Tracer.o bin/AllocProfiler.o bin/TypeFeedback.o bin/HeapSnapshot.o bin/string.o bin/TreeObjectMap.o bin/ASTExecuter.o bin/DebugUtils.o bin/TokenNamespace.o bin/Integer.o bin/BuiltinTable.o bin/Scope.o bin/Null.o bin/Undefined.o bin/NativeFunction.o bin/ObjectConverter.o bin/Boolean.o bin/CodeFunction.o bin/StringType.o bin/Double.o bin/Object.o bin/Array.o bin/VirtualObject.o bin/GarbageCollector.o bin/NativeLoaderType.o bin/Error.o -ldl -lpthread -o bin/ck
+	g++ -O -w -g -std=c++11 src/tools/heapdiff.cpp -o bin/heapdiff
 	
 	./bin/ck -f res/in.ck
 fi
@@ -0,0 +1,522 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TokenNamespace.h"
+#include "ASTCache.h"
+#include "ASTOptimizer.h"
+
+const char *_ast_cache_dir = NULL;
+
+// Kinds of objects stored in nodes
+enum ASTCacheObject {
+	ACO_NONE,
+	ACO_INT,
+	ACO_LONG,
+	ACO_BYTE,
+	ACO_BOOLEAN,
+	ACO_DOUBLE,
+	ACO_STRING,
+	ACO_NAME_CACHE
+};
+
+// Returns kind of object with given index in node of given type.
+// Mirrors objects freed by ~ASTNode.
+static int objectKind(int type, int index) {
+	switch (type) {
+		case INTEGER:
+		case ARRAY:
+			return index == 0 ? ACO_INT : ACO_NONE;
+		case LONG:
+			return index == 0 ? ACO_LONG : ACO_NONE;
+		case BYTE:
+			return index == 0 ? ACO_BYTE : ACO_NONE;
+		case BOOLEAN:
+			return index == 0 ? ACO_BOOLEAN : ACO_NONE;
+		case DOUBLE:
+			return index == 0 ? ACO_DOUBLE : ACO_NONE;
+		case NAME:
+			return index == 0 ? ACO_STRING : index == 1 ? ACO_NAME_CACHE : ACO_NONE;
+		case STRING:
+		case FIELD:
+		case TRY:
+			return index == 0 ? ACO_STRING : ACO_NONE;
+		case OBJECT:
+		case FUNCTION:
+			return ACO_STRING;
+		// type, name, type, name, ...
+		case DEFINE:
+			return index & 1 ? ACO_STRING : ACO_INT;
+		default:
+			return ACO_NONE;
+	}
+};
+
+static unsigned long long hashBytes(const unsigned char *data, long size) {
+	unsigned long long h = 14695981039346656037ull;
+	for (long i = 0; i < size; ++i) {
+		h ^= data[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+};
+
+// Hash of the source text, single step per char
+static unsigned long long hashText(const wchar_t *text, int length) {
+	unsigned long long h = 14695981039346656037ull;
+	for (int i = 0; i < length; ++i) {
+		h ^= (unsigned int) text[i];
+		h *= 1099511628211ull;
+	}
+	return h ^ (unsigned long long) length;
+};
+
+
+// Serialization
+
+struct ASTCacheWriter {
+	unsigned char *data;
+	long           size;
+	long       capacity;
+	bool          error;
+	
+	ASTCacheWriter() {
+		data     = NULL;
+		size     = 0;
+		capacity = 0;
+		error    = 0;
+	};
+	
+	~ASTCacheWriter() {
+		free(data);
+	};
+	
+	void put(unsigned long long v, int bytes) {
+		if (size + bytes > capacity) {
+			capacity = capacity ? capacity * 2 : 4096;
+			data     = (unsigned char*) realloc(data, capacity);
+		}
+		for (int i = 0; i < bytes; ++i)
+			data[size++] = (v >> (8 * i)) & 0xFF;
+	};
+	
+	void putInt(unsigned int v) {
+		put(v, 4);
+	};
+	
+	void putLong(unsigned long long v) {
+		put(v, 8);
+	};
+	
+	// Unsigned LEB128
+	void putVar(unsigned int v) {
+		while (v >= 0x80) {
+			put((v & 0x7F) | 0x80, 1);
+			v >>= 7;
+		}
+		put(v, 1);
+	};
+	
+	// Zigzag encoded, small negative values take single byte
+	void putSigned(int v) {
+		putVar(((unsigned int) v << 1) ^ (unsigned int) (v >> 31));
+	};
+	
+	void putString(string *s) {
+		putVar(s->length);
+		for (int i = 0; i < s->length; ++i)
+			putVar((unsigned int) s->buffer[i]);
+	};
+	
+	void putNode(ASTNode *node) {
+		int children = 0;
+		for (ASTNode *c = node->left; c; c = c->next)
+			++children;
+		
+		int objects = 0;
+		for (ASTObjectList *l = node->objectlist; l; l = l->next)
+			++objects;
+		
+		putSigned(node->type);
+		putSigned(node->lineno);
+		putVar(node->flags);
+		putVar(children);
+		putVar(objects);
+		
+		int index = 0;
+		for (ASTObjectList *l = node->objectlist; l; l = l->next, ++index)
+			switch (objectKind(node->type, index)) {
+				case ACO_INT:        putSigned(*(int*) l->object);                    break;
+				case ACO_LONG:       putLong(*(long*) l->object);                     break;
+				case ACO_BYTE:       put(*(char*) l->object, 1);                      break;
+				case ACO_BOOLEAN:    put(*(bool*) l->object, 1);                      break;
+				case ACO_DOUBLE: {
+					unsigned long long bits;
+					memcpy(&bits, l->object, sizeof(double));
+					putLong(bits);
+					break;
+				}
+				case ACO_STRING:     putString((string*) l->object);                  break;
+				case ACO_NAME_CACHE:                                                  break;
+				
+				// Node has objects unknown to the cache
+				default: error = 1;
+			}
+		
+		for (ASTNode *c = node->left; c; c = c->next)
+			putNode(c);
+	};
+};
+
+struct ASTCacheReader {
+	const unsigned char *data;
+	long                 size;
+	long                  pos;
+	bool                error;
+	Arena              *arena;
+	
+	unsigned long long get(int bytes) {
+		if (pos + bytes > size) {
+			error = 1;
+			return 0;
+		}
+		
+		unsigned long long v = 0;
+		for (int i = 0; i < bytes; ++i)
+			v |= (unsigned long long) data[pos++] << (8 * i);
+		return v;
+	};
+	
+	int getInt() {
+		return (int) get(4);
+	};
+	
+	unsigned long long getLong() {
+		return get(8);
+	};
+	
+	unsigned int getVar() {
+		unsigned int v = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			if (pos >= size)
+				break;
+			
+			unsigned char b = data[pos++];
+			v |= (unsigned int) (b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		error = 1;
+		return 0;
+	};
+	
+	int getSigned() {
+		unsigned int v = getVar();
+		return (int) (v >> 1) ^ -(int) (v & 1);
+	};
+	
+	string *getString() {
+		int length = getVar();
+		if (length < 0 || pos + length > size) {
+			error = 1;
+			return NULL;
+		}
+		
+		string *s = (string*) arena->alloc(sizeof(string));
+		s->length = length;
+		s->size   = length ? length + 1 : 0;
+		s->buffer = NULL;
+		if (length) {
+			s->buffer = (wchar_t*) arena->alloc(s->size * sizeof(wchar_t));
+			for (int i = 0; i < length; ++i)
+				s->buffer[i] = (wchar_t) getVar();
+			s->buffer[length] = 0;
+		}
+		return s;
+	};
+	
+	// Returns node / NULL on error, partial tree stays in the arena
+	ASTNode *getNode(int depth) {
+		ASTNode *node = new (arena) ASTNode(0);
+		node->type    = getSigned();
+		node->lineno  = getSigned();
+		node->flags   = getVar();
+		int children  = getVar();
+		int objects   = getVar();
+		
+		if (error || children < 0 || objects < 0 || depth > 100000) {
+			error = 1;
+			return NULL;
+		}
+		
+		for (int i = 0; i < objects && !error; ++i) {
+			void *object = NULL;
+			
+			switch (objectKind(node->type, i)) {
+				case ACO_INT:        object = astObject<int>(arena, getSigned());          break;
+				case ACO_LONG:       object = astObject<long>(arena, (long) getLong());    break;
+				case ACO_BYTE:       object = astObject<char>(arena, (char) get(1));       break;
+				case ACO_BOOLEAN:    object = astObject<bool>(arena, get(1) != 0);         break;
+				case ACO_STRING:     object = getString();                                 break;
+				case ACO_NAME_CACHE: object = astObject<ASTNameCache>(arena, ASTNameCache()); break;
+				case ACO_DOUBLE: {
+					unsigned long long bits = getLong();
+					double value;
+					memcpy(&value, &bits, sizeof(double));
+					object = astObject<double>(arena, value);
+					break;
+				}
+				default: error = 1;
+			}
+			
+			if (!error)
+				node->addLastObject(object);
+		}
+		
+		for (int i = 0; i < children && !error; ++i) {
+			ASTNode *child = getNode(depth + 1);
+			if (child)
+				node->addChild(child);
+		}
+		
+		return error ? NULL : node;
+	};
+};
+
+
+// Cache entries
+
+#ifndef _WIN32
+
+const char *ast_cache_default_dir() {
+	static char *dir = NULL;
+	
+	if (!dir) {
+		const char *home = getenv("HOME");
+		if (!home || !*home)
+			return NULL;
+		
+		int length = snprintf(NULL, 0, "%s/%s", home, AST_CACHE_DEFAULT_DIR);
+		dir = (char*) malloc(length + 1);
+		snprintf(dir, length + 1, "%s/%s", home, AST_CACHE_DEFAULT_DIR);
+	}
+	
+	return dir;
+};
+
+// Creates directory with all parents
+static bool makeDirectories(const char *path) {
+	char *p = (char*) malloc(strlen(path) + 1);
+	strcpy(p, path);
+	
+	for (char *c = p + 1; *c; ++c)
+		if (*c == '/') {
+			*c = 0;
+			mkdir(p, 0755);
+			*c = '/';
+		}
+	
+	bool result = mkdir(p, 0755) == 0 || errno == EEXIST;
+	free(p);
+	return result;
+};
+
+// Returns malloc'ed path of cache entry for the real path of source
+static char *entryPath(const char *realpath) {
+	unsigned long long h = hashBytes((const unsigned char*) realpath, strlen(realpath));
+	
+	int length  = snprintf(NULL, 0, "%s/%016llx.ckc", _ast_cache_dir, h);
+	char *entry = (char*) malloc(length + 1);
+	snprintf(entry, length + 1, "%s/%016llx.ckc", _ast_cache_dir, h);
+	return entry;
+};
+
+static unsigned long long modificationTime(struct stat *st) {
+	return st->st_mtim.tv_sec * 1000000000ull + st->st_mtim.tv_nsec;
+};
+
+ASTNode *ast_cache_load(const char *path, const wchar_t *text, int length) {
+	if (!_ast_cache_dir)
+		return NULL;
+	
+	char *real = realpath(path, NULL);
+	if (!real)
+		return NULL;
+	
+	struct stat source;
+	if (stat(real, &source) != 0) {
+		free(real);
+		return NULL;
+	}
+	
+	char *entry = entryPath(real);
+	int fd      = open(entry, O_RDONLY);
+	free(entry);
+	
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+		if (fd >= 0)
+			close(fd);
+		free(real);
+		return NULL;
+	}
+	
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		free(real);
+		return NULL;
+	}
+	
+	ASTCacheReader r;
+	r.data  = (const unsigned char*) map;
+	r.size  = st.st_size;
+	r.pos   = 0;
+	r.error = 0;
+	r.arena = NULL;
+	
+	ASTNode *root = NULL;
+	
+	// Header
+	bool valid = (unsigned int) r.getInt() == AST_CACHE_MAGIC
+		&& r.getInt() == AST_CACHE_VERSION
+		&& r.getInt() == sizeof(wchar_t)
+		&& r.getInt() == (_ast_fold_enabled ? AST_CACHE_FOLDED : 0)
+		&& r.getLong() == modificationTime(&source)
+		&& r.getLong() == (unsigned long long) source.st_size
+		&& r.getLong() == hashText(text, length);
+	
+	// Real path, entries of different files may collide by name
+	int path_length = r.getInt();
+	valid = valid && !r.error && path_length == (int) strlen(real) && r.pos + path_length <= r.size 
+		&& !memcmp(r.data + r.pos, real, path_length);
+	r.pos += path_length;
+	
+	if (valid) {
+		long body_size               = (unsigned int) r.getInt();
+		unsigned long long body_hash = r.getLong();
+		
+		valid = !r.error && r.pos + body_size == r.size 
+			&& hashBytes(r.data + r.pos, body_size) == body_hash;
+	}
+	
+	if (valid) {
+		r.arena = new Arena(AST_ARENA_CHUNK_SIZE);
+		root    = r.getNode(0);
+		
+		if (!root || r.pos != r.size) {
+			delete r.arena;
+			root = NULL;
+		} else
+			root->ownArena();
+	}
+	
+	munmap(map, st.st_size);
+	free(real);
+	return root;
+};
+
+bool ast_cache_store(const char *path, const wchar_t *text, int length, ASTNode *root) {
+	if (!_ast_cache_dir || !root)
+		return 0;
+	
+	ASTCacheWriter body;
+	body.putNode(root);
+	if (body.error)
+		return 0;
+	
+	char *real = realpath(path, NULL);
+	if (!real)
+		return 0;
+	
+	struct stat source;
+	if (stat(real, &source) != 0 || !makeDirectories(_ast_cache_dir)) {
+		free(real);
+		return 0;
+	}
+	
+	ASTCacheWriter header;
+	header.putInt(AST_CACHE_MAGIC);
+	header.putInt(AST_CACHE_VERSION);
+	header.putInt(sizeof(wchar_t));
+	header.putInt(_ast_fold_enabled ? AST_CACHE_FOLDED : 0);
+	header.putLong(modificationTime(&source));
+	header.putLong(source.st_size);
+	header.putLong(hashText(text, length));
+	
+	int path_length = strlen(real);
+	header.putInt(path_length);
+	for (int i = 0; i < path_length; ++i)
+		header.put((unsigned char) real[i], 1);
+	
+	header.putInt(body.size);
+	header.putLong(hashBytes(body.data, body.size));
+	
+	// Write into temporary file & rename, concurrent runs see whole entry or nothing
+	char *entry = entryPath(real);
+	free(real);
+	
+	int tmp_length = snprintf(NULL, 0, "%s.%d.tmp", entry, (int) getpid());
+	char *tmp      = (char*) malloc(tmp_length + 1);
+	snprintf(tmp, tmp_length + 1, "%s.%d.tmp", entry, (int) getpid());
+	
+	FILE *out   = fopen(tmp, "wb");
+	bool result = out
+		&& fwrite(header.data, 1, header.size, out) == (size_t) header.size
+		&& fwrite(body.data, 1, body.size, out) == (size_t) body.size;
+	
+	if (out && fclose(out) != 0)
+		result = 0;
+	
+	if (result && rename(tmp, entry) != 0)
+		result = 0;
+	
+	if (!result)
+		unlink(tmp);
+	
+	free(tmp);
+	free(entry);
+	return result;
+};
+
+#else
+
+const char *ast_cache_default_dir() {
+	return NULL;
+};
+
+ASTNode *ast_cache_load(const char *path, const wchar_t *text, int length) {
+	return NULL;
+};
+
+bool ast_cache_store(const char *path, const wchar_t *text, int length, ASTNode *root) {
+	return 0;
+};
+
+#endif
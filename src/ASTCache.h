@@ -0,0 +1,69 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * On-disk cache of parsed trees (ck --cache).
+ * Tree of the script file is serialized after parsing & folding
+ * into <cache dir>/<hash of real path>.ckc and loaded with single
+ * mmap on the next run / import of the same file instead of parsing.
+ * Entry is used only if version, fold mode, mtime, size & hash of the 
+ * source text match, file is parsed again if entry is stale or corrupt.
+ * 
+ * File layout, integers are little endian:
+ *   magic, version, sizeof(wchar_t), flags                 (32 bit)
+ *   source mtime (ns), source size, source text hash       (64 bit)
+ *   path length (32 bit), real path of source
+ *   body size (32 bit), body hash (64 bit), body
+ * Body is tree in pre-order:
+ *   { type, lineno, flags, children count, objects count, { object } }
+ * Body integers are LEB128 (zigzag for signed), objects are stored by 
+ * node type: int as integer, 64 bit long & double, 8 bit byte & boolean, 
+ * strings as length & chars. Name caches of NAME nodes are not stored.
+ */
+
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <wchar.h>
+
+#define AST_CACHE_MAGIC   0x434B4331
+// Increment on change of file layout, node types or node objects
+#define AST_CACHE_VERSION 1
+
+// Header flags
+#define AST_CACHE_FOLDED  1
+
+// Cache directory used by --cache without value
+#define AST_CACHE_DEFAULT_DIR ".cache/ck"
+
+struct ASTNode;
+
+// Directory of cache entries, NULL if cache is disabled
+extern const char *_ast_cache_dir;
+
+// Returns default cache directory ($HOME/.cache/ck) / NULL
+const char *ast_cache_default_dir();
+
+// Returns tree of the file with given source text loaded from cache,
+// NULL if entry is missing, stale or corrupt.
+// Tree is owned by caller and disposed by deleting the root.
+ASTNode *ast_cache_load(const char *path, const wchar_t *text, int length);
+
+// Writes tree of the file into cache, returns 0 on failure
+bool ast_cache_store(const char *path, const wchar_t *text, int length, ASTNode *root);
+
+#endif
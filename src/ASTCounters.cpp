@@ -0,0 +1,224 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ASTCounters.h"
+
+#ifdef AST_VISIT_COUNTERS
+
+#include <cstdio>
+#include <cstdlib>
+
+const char *tokenToString(int token);
+
+struct ASTCounter {
+	// Amount of elements pushed for node
+	unsigned long long entries;
+	// Amount of visit() calls
+	unsigned long long visits;
+	// Cycles spent in visit()
+	unsigned long long cycles;
+};
+
+struct ASTCallSite {
+	ASTCallSite     *next;
+	ASTNode         *node;
+	ASTCounter     counter;
+};
+
+static ASTCounter   ast_counters[AST_COUNTERS_TYPES];
+static ASTCallSite *ast_call_sites[AST_COUNTERS_SITES_SIZE];
+static int          ast_call_sites_count = 0;
+
+static ASTCallSite *callSite(ASTNode *node) {
+	unsigned int h = ((unsigned long) node >> 4) % AST_COUNTERS_SITES_SIZE;
+
+	for (ASTCallSite *s = ast_call_sites[h]; s; s = s->next)
+		if (s->node == node)
+			return s;
+
+	ASTCallSite *s = (ASTCallSite*) calloc(1, sizeof(ASTCallSite));
+	s->node           = node;
+	s->next           = ast_call_sites[h];
+	ast_call_sites[h] = s;
+	++ast_call_sites_count;
+	return s;
+};
+
+void ast_counters_entry(ASTNode *node) {
+	if (!node || node->type < 0 || node->type >= AST_COUNTERS_TYPES)
+		return;
+
+	++ast_counters[node->type].entries;
+
+	if (node->type == CALL)
+		++callSite(node)->counter.entries;
+};
+
+void ast_counters_visit(ASTNode *node, int type, unsigned long long cycles) {
+	if (type < 0 || type >= AST_COUNTERS_TYPES)
+		return;
+
+	++ast_counters[type].visits;
+	ast_counters[type].cycles += cycles;
+
+	if (node && type == CALL) {
+		ASTCallSite *s = callSite(node);
+		++s->counter.visits;
+		s->counter.cycles += cycles;
+	}
+};
+
+// Name of the called function: f(), a.f() / <expression>
+static void callSiteName(ASTNode *node, char *buffer, int size) {
+	ASTNode *f = node->left;
+	string  *name = NULL;
+
+	if (f && (f->type == NAME || f->type == FIELD) && f->objectlist)
+		name = (string*) f->objectlist->object;
+
+	if (!name) {
+		snprintf(buffer, size, "<expression>");
+		return;
+	}
+
+	int i = 0;
+	for (; i < name->length && i < size - 1; ++i)
+		buffer[i] = name->buffer[i] < 128 ? name->buffer[i] : '?';
+	buffer[i] = 0;
+};
+
+static const char *typeName(int type) {
+	const char *name = tokenToString(type);
+	return name && *name ? name : "?";
+};
+
+#ifdef AST_VISIT_COUNTERS_JSON
+static void jsonString(FILE *out, const char *s) {
+	fputc('"', out);
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', out);
+		fputc(*s, out);
+	}
+	fputc('"', out);
+};
+#endif
+
+static int compareTypes(const void *a, const void *b) {
+	ASTCounter *x = &ast_counters[*(int*) a];
+	ASTCounter *y = &ast_counters[*(int*) b];
+
+	if (x->cycles != y->cycles)
+		return x->cycles < y->cycles ? 1 : -1;
+	if (x->visits != y->visits)
+		return x->visits < y->visits ? 1 : -1;
+	return 0;
+};
+
+static int compareSites(const void *a, const void *b) {
+	ASTCallSite *x = *(ASTCallSite**) a;
+	ASTCallSite *y = *(ASTCallSite**) b;
+
+	if (x->counter.cycles != y->counter.cycles)
+		return x->counter.cycles < y->counter.cycles ? 1 : -1;
+	if (x->counter.entries != y->counter.entries)
+		return x->counter.entries < y->counter.entries ? 1 : -1;
+	return 0;
+};
+
+void ast_counters_dump() {
+	int types[AST_COUNTERS_TYPES];
+	int ntypes = 0;
+
+	unsigned long long total_visits = 0;
+	unsigned long long total_cycles = 0;
+
+	for (int i = 0; i < AST_COUNTERS_TYPES; ++i)
+		if (ast_counters[i].visits) {
+			types[ntypes++] = i;
+			total_visits   += ast_counters[i].visits;
+			total_cycles   += ast_counters[i].cycles;
+		}
+
+	qsort(types, ntypes, sizeof(int), compareTypes);
+
+	ASTCallSite **sites = (ASTCallSite**) malloc((ast_call_sites_count + 1) * sizeof(ASTCallSite*));
+	int nsites = 0;
+	for (int i = 0; i < AST_COUNTERS_SITES_SIZE; ++i)
+		for (ASTCallSite *s = ast_call_sites[i]; s; s = s->next)
+			sites[nsites++] = s;
+
+	qsort(sites, nsites, sizeof(ASTCallSite*), compareSites);
+
+	char name[256];
+
+	fprintf(stderr, "\nNode visits: %llu, cycles: %llu\n", total_visits, total_cycles);
+	fprintf(stderr, "%-20s %14s %14s %16s %7s\n", "type", "entries", "visits", "cycles", "cycles%");
+	for (int i = 0; i < ntypes; ++i) {
+		ASTCounter *c = &ast_counters[types[i]];
+		fprintf(stderr, "%-20s %14llu %14llu %16llu %6.2f%%\n", typeName(types[i]), c->entries, c->visits, c->cycles,
+			total_cycles ? 100.0 * c->cycles / total_cycles : 0.0);
+	}
+
+	fprintf(stderr, "\nCall sites: %d\n", nsites);
+	fprintf(stderr, "%-32s %6s %14s %14s %16s\n", "function", "line", "calls", "visits", "cycles");
+	for (int i = 0; i < nsites && i < AST_COUNTERS_SITES_TOP; ++i) {
+		callSiteName(sites[i]->node, name, sizeof(name));
+		fprintf(stderr, "%-32s %6d %14llu %14llu %16llu\n", name, sites[i]->node->lineno,
+			sites[i]->counter.entries, sites[i]->counter.visits, sites[i]->counter.cycles);
+	}
+
+#ifdef AST_VISIT_COUNTERS_JSON
+	FILE *out = fopen(AST_VISIT_COUNTERS_JSON, "w");
+	if (out) {
+		fprintf(out, "{\n\t\"types\": [");
+		for (int i = 0; i < ntypes; ++i) {
+			ASTCounter *c = &ast_counters[types[i]];
+			fprintf(out, "%s\n\t\t{\"type\": %d, \"name\": ", i ? "," : "", types[i]);
+			jsonString(out, typeName(types[i]));
+			fprintf(out, ", \"entries\": %llu, \"visits\": %llu, \"cycles\": %llu}", c->entries, c->visits, c->cycles);
+		}
+		fprintf(out, "\n\t],\n\t\"call_sites\": [");
+		for (int i = 0; i < nsites; ++i) {
+			callSiteName(sites[i]->node, name, sizeof(name));
+			fprintf(out, "%s\n\t\t{\"function\": ", i ? "," : "");
+			jsonString(out, name);
+			fprintf(out, ", \"line\": %d, \"calls\": %llu, \"visits\": %llu, \"cycles\": %llu}",
+				sites[i]->node->lineno, sites[i]->counter.entries, sites[i]->counter.visits, sites[i]->counter.cycles);
+		}
+		fprintf(out, "\n\t]\n}\n");
+		fclose(out);
+	}
+#endif
+
+	free(sites);
+
+	// Call sites refer to nodes of disposed tree
+	for (int i = 0; i < AST_COUNTERS_SITES_SIZE; ++i)
+		while (ast_call_sites[i]) {
+			ASTCallSite *s = ast_call_sites[i]->next;
+			free(ast_call_sites[i]);
+			ast_call_sites[i] = s;
+		}
+	ast_call_sites_count = 0;
+
+	for (int i = 0; i < AST_COUNTERS_TYPES; ++i)
+		ast_counters[i].entries = ast_counters[i].visits = ast_counters[i].cycles = 0;
+};
+
+#endif
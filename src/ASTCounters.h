@@ -0,0 +1,81 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Instrumentation of ASTExecuter::visit.
+ * Enabled with AST_VISIT_COUNTERS in ASTExecuter.h,
+ * all macros are empty otherwise.
+ */
+
+#ifndef AST_COUNTERS_H
+#define AST_COUNTERS_H
+
+#include "ASTExecuter.h"
+
+#ifdef AST_VISIT_COUNTERS
+
+#ifdef AST_VISIT_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AST_COUNTERS_TSC() __rdtsc()
+#else
+#include <time.h>
+static inline unsigned long long ast_counters_clock() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+};
+#define AST_COUNTERS_TSC() ast_counters_clock()
+#endif
+#else
+#define AST_COUNTERS_TSC() 0
+#endif
+
+// Amount of node types tracked
+#define AST_COUNTERS_TYPES      256
+// Amount of buckets in call site table
+#define AST_COUNTERS_SITES_SIZE 1024
+// Amount of call sites printed
+#define AST_COUNTERS_SITES_TOP  20
+
+// Called when new element is pushed for the node
+void ast_counters_entry(ASTNode *node);
+
+// Called after each visit of node with given type
+void ast_counters_visit(ASTNode *node, int type, unsigned long long cycles);
+
+// Prints sorted table to stderr, writes JSON if enabled
+void ast_counters_dump();
+
+#define AST_COUNTERS_ENTRY(node)   ast_counters_entry(node);
+#define AST_COUNTERS_BEGIN(element) \
+	ASTNode           *ast_counters_node  = (element)->attached_node; \
+	int                ast_counters_type  = ast_counters_node ? ast_counters_node->type : (((element)->data & DATA10_MASK) >> DATA10_OFFSET); \
+	unsigned long long ast_counters_start = AST_COUNTERS_TSC();
+#define AST_COUNTERS_END            ast_counters_visit(ast_counters_node, ast_counters_type, AST_COUNTERS_TSC() - ast_counters_start);
+#define AST_COUNTERS_DUMP()         ast_counters_dump();
+
+#else
+
+#define AST_COUNTERS_ENTRY(node)
+#define AST_COUNTERS_BEGIN(element)
+#define AST_COUNTERS_END
+#define AST_COUNTERS_DUMP()
+
+#endif
+
+#endif
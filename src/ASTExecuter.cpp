@@ -28,6 +28,10 @@
 #include "FakeStream.h"
 
 #include "ASTExecuter.h"
+#include "Profiler.h"
+#include "ASTCounters.h"
+#include "Tracer.h"
+#include "TypeFeedback.h"
 #include "DebugUtils.h"
 #include "ColoredOutput.h"
 #include "TokenNamespace.h"
@@ -344,6 +348,11 @@ void ASTObjectStack::mark() {
 	}
 };
 
+void ASTObjectStack::references(GC_Visitor *visitor) {
+	for (ASTObjectElement *e = head; e; e = e->next)
+		visitor->visit(e->object);
+};
+
 void ASTObjectStack::finalize() {};
 
 
@@ -355,6 +364,7 @@ ASTExecuterStackTraceElement::ASTExecuterStackTraceElement() {
 	this->level       = (unsigned int) (-1) >> 1;
 	this->type        = ASTESTE_UNDEFINED;
 	this->tracename   = "";
+	this->elided      = 0;
 };
 	
 // -- - ASTExecuterStackTraceElement::~ASTExecuterStackTraceElement() {
@@ -477,7 +487,8 @@ void ASTExecuterStackTrace::pop(int level) {
 	// printf("POP = %d %S\n", level, head->tracename.toCharSequence());
 	--size;
 	--pos_size;
-	head->level = (unsigned int) (-1) >> 1;
+	head->level  = (unsigned int) (-1) >> 1;
+	head->elided = 0;
 	head = head->next;
 };
 
@@ -485,8 +496,9 @@ void ASTExecuterStackTrace::popForLevel(int level) {
 	while (head && head->level >= level) {
 		--size;
 		--pos_size;
-		head->level = (unsigned int) (-1) >> 1;
-		head        = head->next;
+		head->level  = (unsigned int) (-1) >> 1;
+		head->elided = 0;
+		head         = head->next;
 	}
 };
 
@@ -671,6 +683,23 @@ int ASTExecuterStackTrace::push(int level, string file) {
 };
 
 
+int ASTExecuterStackTrace::replace(int level, int lineno, string name, ASTExecuterStackTraceElementType type) {
+	if (!head || head->level != level)
+		return type == ASTESTE_NAME ? push(level, lineno, name) : push(level, lineno);
+	
+	// Replaced function is shown with line of the tail call.
+	// Line of the record stays the call site in the enclosing frame.
+	int i = head->elided % AST_TAIL_TRACE_SIZE;
+	head->elided_names[i]   = head->type == ASTESTE_NAME ? head->tracename : string("<anonymous>");
+	head->elided_linenos[i] = lineno;
+	++head->elided;
+	
+	head->type        = type;
+	head->tracename   = name;
+	return 1;
+};
+
+
 // ASTExecuter 
 ASTExecuter::ASTExecuter() {
 	_error        = 0;
@@ -857,6 +886,7 @@ void ASTExecuter::binaryOperatorCall(ASTExecuterElement *element, ASTNode *node,
 			stackoverflow_error(this, STACKTRACE_STACK);
 			return;
 		}
+		TYPE_FEEDBACK(node, astobjstack->head->next->object, astobjstack->head->object)
 		nativeCall(element->scope, astobjstack->head->next->object->get(element->scope, &key), 2, astobjstack->head->next->object, astobjstack->head->object);
 		
 	} else if (element->data & FLAG_3) {
@@ -908,6 +938,7 @@ void ASTExecuter::binaryLogicalOperatorCall(ASTExecuterElement *element, ASTNode
 			stackoverflow_error(this, STACKTRACE_STACK);
 			return;
 		}
+		TYPE_FEEDBACK(node, astobjstack->head->next->object, astobjstack->head->object)
 		nativeCall(element->scope, astobjstack->head->next->object->get(element->scope, &key), 2, astobjstack->head->next->object, astobjstack->head->object);
 		
 	} else if (element->data & FLAG_3) {
@@ -978,6 +1009,7 @@ void ASTExecuter::unaryOperatorCall(ASTExecuterElement *element, ASTNode *node,
 			stackoverflow_error(this, STACKTRACE_STACK);
 			return;
 		}
+		TYPE_FEEDBACK(node, astobjstack->head->object, NULL)
 		nativeCall(element->scope, astobjstack->head->object->get(element->scope, &key), 1, astobjstack->head->object);
 	}
 };
@@ -1439,8 +1471,12 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 						element->target = NULL;
 					}
 					
-					element->scope  = new Scope(element->next ? element->next->scope : NULL);
-					GC.gc_attach_root(element->scope);
+					if (node->flags & NODE_SCOPE_FREE) 
+						element->scope  = element->next ? element->next->scope : NULL;
+					else {
+						element->scope  = new Scope(element->next ? element->next->scope : NULL);
+						GC.gc_attach_root(element->scope);
+					}
 					
 					element->target = node->left;
 					element->data  |= FLAG_1;
@@ -1532,8 +1568,12 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 			if (element->target == NULL) {
 				element->data  |= FLAG_1;
 				element->target = node->left;
-				element->scope  = new Scope(element->next ? element->next->scope : NULL);
-				GC.gc_attach_root(element->scope);
+				if (node->flags & NODE_SCOPE_FREE) 
+					element->scope  = element->next ? element->next->scope : NULL;
+				else {
+					element->scope  = new Scope(element->next ? element->next->scope : NULL);
+					GC.gc_attach_root(element->scope);
+				}
 				return;
 			}
 			
@@ -1857,7 +1897,17 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 		
 		case NAME: {
 			if (element->next && element->next->scope) {
-				VirtualObject *o = element->next->scope->get(element->scope, (string*) node->objectlist->object);
+				Scope        *scope = element->next->scope;
+				ASTNameCache *cache = node->objectlist->next ? (ASTNameCache*) node->objectlist->next->object : NULL;
+				VirtualObject    *o = cache ? scope_cached(scope, cache) : NULL;
+				
+				if (!o) {
+					o = scope->get(element->scope, (string*) node->objectlist->object);
+					
+					if (cache)
+						scope_cache(scope, (string*) node->objectlist->object, o, cache);
+				}
+				
 				if (o) {
 					if (!astobjstack->push(o, depth - 1)) 
 						stackoverflow_error(this, OBJECT_STACK);
@@ -1888,11 +1938,14 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 			while (scope) {
 				if (scope->type == PROXY_SCOPE) 
 					break;
+				if (scope->type == CALL_SCOPE && ((CallScope*) scope)->object) 
+					break;
 				scope = scope->parent;
 			}
 			
 			if (scope) {
-				if (!astobjstack->push(((ProxyScope*) scope)->object, depth - 1)) 
+				VirtualObject *o = scope->type == CALL_SCOPE ? ((CallScope*) scope)->object : ((ProxyScope*) scope)->object;
+				if (!astobjstack->push(o, depth - 1)) 
 					stackoverflow_error(this, OBJECT_STACK);
 			} else if (element->next && element->next->scope) {
 				if (!astobjstack->push(element->next->scope, depth - 1)) 
@@ -2080,7 +2133,7 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 					element->data &= ~FLAG_3;
 					// element->data &= ~FLAG_5; -> causes memory leak of unrooting scopes
 					// Push value up
-					if (((element->data & USER16_MASK) >> USER16_OFFSET) == (astobjstack->size & 1))
+					if (((element->data & USER16_PARITY) != 0) == (astobjstack->size & 1))
 						astobjstack->push(new Undefined, depth - 1);
 					else
 						astobjstack->pullUp(depth);
@@ -2111,7 +2164,7 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 				}
 				
 				int n = 0;
-				int expected_argc   = element->data & USER16_MASK;
+				int expected_argc   = element->data & USER16_ARGC;
 				ASTObjectElement *e = astobjstack->head;
 				
 				// astobjstack->print();
@@ -2139,7 +2192,8 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 				//						 used for checking for return value
 				//                       if no value returned, user16 == (astobjstack->size after execution) % 2
 				
-				element->data |= (astobjstack->size & 1) << USER16_OFFSET;
+				if (astobjstack->size & 1)
+					element->data |= USER16_PARITY;
 					
 				while (e->next && e->next->level == depth) {
 					++n;
@@ -2165,6 +2219,8 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 						args[i] = new Undefined;
 				}
 				
+				TYPE_FEEDBACK(node, r, f)
+				
 				if (f) {
 					if (f->type == UNDEFINED || f->type == TNULL) {
 						if (!astobjstack->push(new Undefined, depth - 1)) {
@@ -2172,26 +2228,20 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 							return;
 						}
 						
+					} else if (f->type == CODE_FUNCTION && (node->flags & NODE_TAIL_CALL) && tailCall(element, depth, (CodeFunction*) f, r, expected_argc, args)) {
+						// Calling frame replaced, element is already left
 					} else if (f->type == CODE_FUNCTION) {
-						if (r)
-							element->scope = new Scope(new ProxyScope(((CodeFunction*) f)->scope, r));
-						else
-							element->scope = new Scope(((CodeFunction*) f)->scope);
+						// Frame holds arguments & reference, see CallScope
+						element->scope = new CallScope((CodeFunction*) f, r, expected_argc, args);
 						
 						GC.gc_attach_root(element->scope);
 						
 						element->data  |= FLAG_5;
 						
-						element->target = ((CodeFunction*) f)->node->left;
-						
-						// Append all arguments into __arguments Array
-						Array *__arguments = new Array();
-						for (int i = 0; i < expected_argc; ++i)
-							__arguments->array->push(args[i]);
-						string key = "__arguments";
-						element->scope->define(&key, __arguments);
+						if (_tracer_enabled)
+							tracer_enter(this, depth);
 						
-						f->call(element->scope, expected_argc, args);
+						element->target = ((CodeFunction*) f)->node->left;
 					} else {
 						if (r)
 							element->scope = new Scope(new ProxyScope(element->next ? element->next->scope : NULL, r));
@@ -2209,6 +2259,9 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 						
 						element->data  |= FLAG_5;
 						
+						if (_tracer_enabled)
+							tracer_enter(this, depth);
+						
 						element->target = NULL;
 						
 						// Append all arguments into __arguments Array
@@ -2539,25 +2592,16 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 								return;
 							}
 						} else if (f->type == CODE_FUNCTION) {
-							if (r)
-								element->scope = new Scope(new ProxyScope(((CodeFunction*) f)->scope, r));
-							else
-								element->scope = new Scope(((CodeFunction*) f)->scope);
+							element->scope = new CallScope((CodeFunction*) f, r, n, args);
 							
 							GC.gc_attach_root(element->scope);
 							
 							element->data  |= FLAG_2;
 							
-							element->target = ((CodeFunction*) f)->node->left;
-						
-							// Append all arguments into __arguments Array
-							Array *__arguments = new Array();
-							for (int i = 0; i < n; ++i)
-								__arguments->array->push(args[i]);
-							string key = "__arguments";
-							element->scope->define(&key, __arguments);
+							if (_tracer_enabled)
+								tracer_enter(this, depth, 1);
 							
-							f->call(element->scope, n, args);
+							element->target = ((CodeFunction*) f)->node->left;
 						} else {
 							if (r)
 								element->scope = new Scope(new ProxyScope(element->scope, r));
@@ -2575,6 +2619,9 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 							
 							element->data  |= FLAG_2;
 							
+							if (_tracer_enabled)
+								tracer_enter(this, depth, 1);
+							
 							element->target = NULL;
 						
 							// Append all arguments into __arguments Array
@@ -3586,6 +3633,8 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 				string key               = objectStringValue(astobjstack->peek(depth));
 				VirtualObject *reference = astobjstack->peek(1, depth);
 				
+				TYPE_FEEDBACK(node, reference, astobjstack->peek(depth))
+				
 				if (!defined(reference)) {
 					if (!astobjstack->push(new Undefined, depth - 1)) 
 						stackoverflow_error(this, OBJECT_STACK);
@@ -3623,6 +3672,8 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 			else {
 				// Left calculated
 				element->target = NULL;
+				
+				TYPE_FEEDBACK(node, astobjstack->head->object, NULL)
 					
 				VirtualObject *o = astobjstack->head->object->get(element->scope, ((string*) node->objectlist->object));
 				
@@ -3638,6 +3689,76 @@ void ASTExecuter::visit(ASTExecuterElement *element, ASTNode *node, int depth) {
 	};
 };
 
+bool ASTExecuter::tailCall(ASTExecuterElement *element, int depth, CodeFunction *f, VirtualObject *r, int argc, VirtualObject **args) {
+	// Find frame of the calling function.
+	// Frame can not be replaced from inside of TRY.
+	ASTExecuterElement *caller = element->next;
+	int level                  = depth - 1;
+	
+	while (1) {
+		if (!caller)
+			return 0;
+		
+		if (caller->attached_node) {
+			if (caller->attached_node->type == TRY)
+				return 0;
+			if (caller->attached_node->type == CALL) 
+				if (caller->data & FLAG_5)
+					break;
+				else
+					return 0;
+			if (caller->attached_node->type == IMPORTED_SCRIPT)
+				return 0;
+		} else if (((caller->data & DATA10_MASK) >> DATA10_OFFSET) == NATIVE_CALL) 
+			if (caller->data & FLAG_2)
+				break;
+			else
+				return 0;
+		else 
+			return 0;
+		
+		caller = caller->next;
+		--level;
+	}
+	
+	// Save name of the called function & line of the tail call
+	ASTExecuterStackTraceElementType trace_type = ASTESTE_UNDEFINED;
+	string trace_name;
+	int trace_lineno = element->attached_node->lineno;
+	if (aststacktrace->head && aststacktrace->head->level == depth) {
+		trace_type   = aststacktrace->head->type;
+		trace_name   = aststacktrace->head->tracename;
+	}
+	
+	Scope *scope = new CallScope(f, r, argc, args);
+	GC.gc_attach_root(scope);
+	
+	// Leave all nodes of the calling function body
+	int i = 0;
+	while (caller != aststack->head) {
+		leave(aststack->head, aststack->head->attached_node, depth - i++);
+		aststack->pop();
+	}
+	
+	if (caller->scope)
+		GC.gc_deattach_root(caller->scope);
+	
+	caller->scope   = scope;
+	caller->target  = f->node->left;
+	caller->data   &= ~FLAG_0;
+	
+	if (!aststacktrace->replace(level, trace_lineno, trace_name, trace_type))
+		stackoverflow_error(this, STACKTRACE_STACK);
+	
+	// Replaced function leaves, called one enters the same frame
+	if (_tracer_enabled) {
+		tracer_end(TRACER_FUNCTION);
+		tracer_enter(this, level);
+	}
+	
+	return 1;
+};
+
 // Called when node is never more been visited
 void ASTExecuter::leave(ASTExecuterElement *element, ASTNode *node, int depth) {
 	
@@ -3666,7 +3787,7 @@ void ASTExecuter::leave(ASTExecuterElement *element, ASTNode *node, int depth) {
 			break;
 			
 		case FOR:
-			if (element->scope)
+			if (element->scope && !(node->flags & NODE_SCOPE_FREE))
 				GC.gc_deattach_root(element->scope);
 			GC.gc_collect();
 			break;
@@ -3676,18 +3797,22 @@ void ASTExecuter::leave(ASTExecuterElement *element, ASTNode *node, int depth) {
 			break;
 			
 		case BLOCK:
-			if (element->scope) 
+			if (element->scope && !(node->flags & NODE_SCOPE_FREE)) 
 				GC.gc_deattach_root(element->scope);
 			GC.gc_collect();
 			break;
 			
 		case CALL:
+			if (_tracer_enabled && element->data & FLAG_5)
+				tracer_end(TRACER_FUNCTION);
 			if (element->data & FLAG_5 && element->scope) 
 				GC.gc_deattach_root(element->scope);
 			GC.gc_collect();
 			break;
 			
 		case NATIVE_CALL:
+			if (_tracer_enabled && element->data & FLAG_2)
+				tracer_end(TRACER_FUNCTION);
 			if (element->data & FLAG_2 && element->scope) 
 				GC.gc_deattach_root(element->scope);
 			GC.gc_collect();
@@ -3697,9 +3822,11 @@ void ASTExecuter::leave(ASTExecuterElement *element, ASTNode *node, int depth) {
 			break;
 		
 		case IMPORTED_SCRIPT:
+			if (_tracer_enabled)
+				tracer_end(TRACER_IMPORT);
 			GC.gc_deattach_root(element->scope);
 			delete element->scope->context;
-			delete node;
+			// Tree is owned by imported_scripts
 			GC.gc_collect();
 			break;
 		
@@ -3733,12 +3860,19 @@ void ASTExecuter::begin(Context *context, ASTNode *root) {
 		if (!_global_exec_state)
 			break;
 		
+		if (_profiler_pending)
+			profiler_sample(this);
+		
+		AST_COUNTERS_BEGIN(aststack->head)
+		
 		try {
 			visit(aststack->head, aststack->head ? aststack->head->attached_node : NULL, aststack->size);
 		} catch(...) {
 			raiseError("Unhandled Execution Error");
 		}
 		
+		AST_COUNTERS_END
+		
 		if (_error)
 			break;
 		
@@ -3760,6 +3894,7 @@ void ASTExecuter::begin(Context *context, ASTNode *root) {
 				break;
 			}
 			aststack->head->attached_node = node;
+			AST_COUNTERS_ENTRY(node)
 		}
 	}
 	
@@ -3785,6 +3920,7 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 		ExecuterResult r;
 		r.object = NULL;
 		r.type   = ERT_UNDEF;
+		return r;
 	}
 	
 	// New alternate root scope for overwritting access to the global scope.
@@ -3797,14 +3933,20 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 	new_scope->context    = new_context;
 	
 	// Set up error handling for this executer.
+	// Handler can not capture locals, result of the current call is passed 
+	// through static pointers, restored on return for nested calls.
 	VirtualObject *result_error = NULL;
 	bool result_error_flag      = 0;
-	VirtualObject **result_error_ptr = &result_error;
-	bool *result_error_flag_ptr = &result_error_flag;
 	
-	auto la = [=] (VirtualObject *error) { *result_error_ptr = error; *result_error_flag_ptr = 1; };
-	static auto static_variable = la;
-	this->error_handler = [](VirtualObject *error) { return static_variable(error); };
+	static VirtualObject **result_error_ptr      = NULL;
+	static bool           *result_error_flag_ptr = NULL;
+	
+	VirtualObject **outer_error_ptr      = result_error_ptr;
+	bool           *outer_error_flag_ptr = result_error_flag_ptr;
+	result_error_ptr      = &result_error;
+	result_error_flag_ptr = &result_error_flag;
+	
+	this->error_handler = [](VirtualObject *error) { *result_error_ptr = error; *result_error_flag_ptr = 1; };
 	
 	if (function->type != CODE_FUNCTION) {
 		Scope *clscope;
@@ -3829,6 +3971,9 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 		GC.gc_unlock(result_error);
 		GC.gc_unlock(f);
 		
+		result_error_ptr      = outer_error_ptr;
+		result_error_flag_ptr = outer_error_flag_ptr;
+		
 		ExecuterResult r;
 		if (result_error_flag) {
 			r.object = result_error;
@@ -3861,11 +4006,18 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 		if (!_global_exec_state)
 			break;
 		
+		if (_profiler_pending)
+			profiler_sample(this);
+		
+		AST_COUNTERS_BEGIN(aststack->head)
+		
 		try {
 			visit(aststack->head, aststack->head ? aststack->head->attached_node : NULL, aststack->size);
 		} catch(...) {
 			raiseError("Unhandled Exception");
 		}
+		
+		AST_COUNTERS_END
 		if (_error)
 			break;
 		
@@ -3893,6 +4045,7 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 				break;
 			}
 			aststack->head->attached_node = node;
+			AST_COUNTERS_ENTRY(node)
 		}
 	}
 	
@@ -3917,6 +4070,9 @@ ExecuterResult ASTExecuter::beginFunction(Scope *scope, VirtualObject *reference
 	GC.gc_unlock(result_error);
 	GC.gc_deattach_root(new_scope);
 	
+	result_error_ptr      = outer_error_ptr;
+	result_error_flag_ptr = outer_error_flag_ptr;
+	
 	ExecuterResult r;
 	if (result_error_flag) {
 		r.object = result_error;
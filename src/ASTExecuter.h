@@ -66,6 +66,10 @@
 // FLAG_1: used for handling multiple executions of single node
 // FLAG_2, FLAG_3, FLAG_4, FLAG_5: i dunno lol
 
+// CALL: USER16 holds arguments count, highest bit holds object stack parity
+#define USER16_PARITY  0b00000000000000001000000000000000
+#define USER16_ARGC    0b00000000000000000111111111111111
+
 #define DATA10_OFFSET  16
 #define FLAGS_OFFSET   26
 #define USER16_OFFSET   0
@@ -76,11 +80,20 @@
 
 #define MIN_AST_STACK_SIZE      16
 
+// Amount of frames, replaced by tail calls, stored per stacktrace record
+#define AST_TAIL_TRACE_SIZE      8
+
 #define EXECUTION_STACK  0
 #define OBJECT_STACK     1
 #define STACKTRACE_STACK 2
 
 // #define AST_VISIT_PRINT
+// Count visits of every node type & call site, print table on exit
+// #define AST_VISIT_COUNTERS
+// Also measure time of visits in cycles (rdtsc)
+// #define AST_VISIT_CYCLES
+// Also write counters as JSON into the given file
+// #define AST_VISIT_COUNTERS_JSON "ck.counters.json"
 // #define VARIABLES_PRINT
 
 
@@ -204,6 +217,8 @@ struct ASTObjectStack : GC_Object {
 	
 	void mark();
 	
+	void references(GC_Visitor *visitor);
+	
 	void finalize();
 };
 
@@ -230,6 +245,11 @@ struct ASTExecuterStackTraceElement {
 	int                             level;
 	// Defins current storage type. If not set, name should be <anunymous>
 	ASTExecuterStackTraceElementType type;
+	// Amount of frames replaced by tail calls on this level
+	int                            elided;
+	// The last replaced frames, ring buffer indexed by elided
+	string      elided_names[AST_TAIL_TRACE_SIZE];
+	int       elided_linenos[AST_TAIL_TRACE_SIZE];
 	
 	ASTExecuterStackTraceElement();
 	
@@ -302,6 +322,10 @@ struct ASTExecuterStackTrace {
 	int push(int level, string file);
 	
 	int push(int level, int lineno);
+	
+	// Replaces record of the given level on tail call.
+	// Previous record is kept in elided records with lineno of the tail call.
+	int replace(int level, int lineno, string name, ASTExecuterStackTraceElementType type);
 };
 
 
@@ -329,6 +353,8 @@ typedef void (*error_handler_function_type) (VirtualObject*);
 // esse cillum dolore eu fugiat nulla pariatur. Excepteur sint 
 // occaecat cupidatat non proident, sunt in culpa qui officia 
 // deserunt mollit anim id est laborum.
+struct CodeFunction;
+
 struct ASTExecuter {	
 	bool                               _error;
 	ASTExecuterStack                *aststack;
@@ -367,6 +393,11 @@ struct ASTExecuter {
 	
 	// </OverHandlers>
 	
+	// Replaces frame of the calling function with call of the given one.
+	// Used for CALL nodes in tail position. Returns 0 if the frame can 
+	// not be replaced and call should be performed as usual.
+	bool tailCall(ASTExecuterElement *element, int depth, CodeFunction *f, VirtualObject *r, int argc, VirtualObject **args);
+	
 	void raiseError(const char *message);
 	
 	void raiseError(string message);
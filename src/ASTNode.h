@@ -18,12 +18,54 @@
 /*
  * Instance of ASTNode represents single node of AST-parsed tree. 
  * Used while executing code or just printing it out.
+ * 
+ * Parser allocates nodes, object lists and literal values of the 
+ * tree from single Arena owned by the root node, so tree is built 
+ * without separate heap allocations and disposed at once by deleting 
+ * the root. Nodes created with plain new (CodeFunction wrapper) stay 
+ * on the heap and own their children & objects as before.
  */
 
 #ifndef ASTNODE_H
 #define ASTNODE_H
 
+#include <new>
+
 #include "string.h"
+#include "Arena.h"
+
+// ASTNode flags, computed by parser after building the tree
+// Node (BLOCK / FOR) declares no own variables, assigns only names that
+// exist in enclosing scopes and executes in enclosing Scope
+#define NODE_SCOPE_FREE 0b00000001
+// CALL node is the value of RETURN and can replace the calling frame
+#define NODE_TAIL_CALL  0b00000010
+
+// Default size of AST arena chunk in bytes
+#define AST_ARENA_CHUNK_SIZE 16384
+// Bit of node header marking node that disposes it's arena
+#define AST_ARENA_OWNER      1UL
+
+struct Scope;
+struct TreeObjectMapEntry;
+
+// Resolution of NAME node that refers to global variable.
+// Stored as second object of NAME node if name is not declared 
+// by any enclosing function / block and can be cached.
+struct ASTNameCache {
+	// Entry of global Scope table holding the value
+	TreeObjectMapEntry *cell;
+	// Global Scope, cell belongs to
+	Scope            *global;
+	// scope_version at the moment of caching / -1
+	int              version;
+	
+	ASTNameCache() {
+		cell    = NULL;
+		global  = NULL;
+		version = -1;
+	};
+};
 
 struct ASTObjectList {
 	ASTObjectList *next;
@@ -55,24 +97,106 @@ struct ASTObjectList {
 	};
 };
 
+// Allocates copy of value in the arena / on the heap if arena is NULL
+template <typename T> static inline T *astObject(Arena *arena, T value) {
+	if (!arena)
+		return new T(value);
+	
+	T *object = (T*) arena->alloc(sizeof(T));
+	*object   = value;
+	return object;
+};
+
+// Allocates string in the arena / on the heap if arena is NULL.
+// Arena strings are never passed to ~string.
+static inline string *astString(Arena *arena, const wchar_t *data, int length) {
+	if (!arena)
+		return new string(data, length);
+	
+	string *s = (string*) arena->alloc(sizeof(string));
+	s->length = length > 0 ? length : 0;
+	s->size   = s->length ? s->length + 1 : 0;
+	s->buffer = NULL;
+	
+	if (s->length) {
+		s->buffer = (wchar_t*) arena->alloc(s->size * sizeof(wchar_t));
+		for (int i = 0; i < length; ++i)
+			s->buffer[i] = data[i];
+		s->buffer[length] = 0;
+	}
+	return s;
+};
+
 struct ASTNode {
 	int       type;
 	int     lineno;
 	ASTNode  *left;
 	ASTNode *right;
 	ASTNode  *next;
+	int      flags;
 	
 	// For storing local data like arrays, integers, strings.. e.t.c.
 	ASTObjectList *objectlist;
 	
 	void* (*node_visit)(void);
 	
+	// Each node is preceded by header word holding the Arena 
+	// it was allocated from (NULL for heap nodes) and AST_ARENA_OWNER bit.
+	
+	static void *operator new(size_t size) {
+		unsigned long *header = (unsigned long*) malloc(sizeof(unsigned long) + size);
+		if (!header)
+			throw std::bad_alloc();
+		*header = 0;
+		return header + 1;
+	};
+	
+	static void *operator new(size_t size, Arena *arena) {
+		if (!arena)
+			return operator new(size);
+		
+		unsigned long *header = (unsigned long*) arena->alloc(sizeof(unsigned long) + size);
+		*header = (unsigned long) arena;
+		return header + 1;
+	};
+	
+	// Heap nodes are freed, arena nodes are released with the arena 
+	// when it's owner is deleted.
+	static void operator delete(void *node) {
+		if (!node)
+			return;
+		
+		unsigned long *header = (unsigned long*) node - 1;
+		
+		if (!*header)
+			free(header);
+		else if (*header & AST_ARENA_OWNER)
+			delete (Arena*) (*header & ~AST_ARENA_OWNER);
+	};
+	
+	static void operator delete(void *node, Arena *arena) {
+		operator delete(node);
+	};
+	
+	// Returns Arena of the node / NULL for heap node
+	static Arena *arenaOf(ASTNode *node) {
+		return (Arena*) (((unsigned long*) node)[-1] & ~AST_ARENA_OWNER);
+	};
+	
+	// Makes node dispose it's arena when deleted
+	void ownArena() {
+		unsigned long *header = (unsigned long*) this - 1;
+		if (*header)
+			*header |= AST_ARENA_OWNER;
+	};
+	
 	ASTNode(int lineno) {
 		this->lineno = lineno;
 		this->left   = NULL;
 		this->right  = NULL;
 		this->next   = NULL;
 		this->objectlist = NULL;
+		this->flags      = 0;
 	};
 	
 	ASTNode(int lineno, int type) {
@@ -82,6 +206,7 @@ struct ASTNode {
 		this->right  = NULL;
 		this->next   = NULL;
 		this->objectlist = NULL;
+		this->flags      = 0;
 	};
 	
 	ASTNode(int lineno, ASTNode *child) {
@@ -90,6 +215,7 @@ struct ASTNode {
 		this->right  = child;
 		child->next  = NULL;
 		this->objectlist = NULL;
+		this->flags      = 0;
 	};
 	
 	ASTNode(int lineno, ASTNode *left, ASTNode *right) {
@@ -99,9 +225,14 @@ struct ASTNode {
 		left->next   = right;
 		right->next  = NULL;
 		this->objectlist = NULL;
+		this->flags      = 0;
 	};
 	
 	~ASTNode() {
+		// Children & objects of arena node live in the same arena
+		if (arenaOf(this))
+			return;
+		
 		if (left == NULL);
 		else if (left == right)
 			delete left;
@@ -141,6 +272,16 @@ struct ASTNode {
 				break;
 				
 			case NAME:
+				if (objectlist) {
+					delete (string*) (objectlist->object);
+					
+					if (objectlist->next) {
+						delete (ASTNameCache*) (objectlist->next->object);
+						delete objectlist->next;
+					}
+				}
+				break;
+				
 			case STRING:
 				if (objectlist)
 					delete (string*) (objectlist->object);
@@ -225,6 +366,15 @@ struct ASTNode {
 		return this;
 	};
 	
+	// Allocates list element in the arena of the node
+	ASTObjectList *newObjectList(void *object) {
+		Arena *arena = arenaOf(this);
+		
+		if (arena)
+			return new (arena->alloc(sizeof(ASTObjectList))) ASTObjectList(object);
+		return new ASTObjectList(object);
+	};
+	
 	ASTNode *addLastObject(void *object) {
 		if (object != NULL) {
 			ASTObjectList *tmp = objectlist;
@@ -232,21 +382,21 @@ struct ASTNode {
 			// Insert into end
 		
 			if (tmp == NULL) {
-				objectlist = new ASTObjectList(object);
+				objectlist = newObjectList(object);
 				return this;
 			}
 			
 			while (tmp->next)
 				tmp = tmp->next;
 			
-			tmp->next = new ASTObjectList(object);
+			tmp->next = newObjectList(object);
 		}
 		return this;
 	};
 	
 	ASTNode *addFirstObject(void *object) {
 		if (object != NULL) {
-			ASTObjectList *tmp = new ASTObjectList(object);
+			ASTObjectList *tmp = newObjectList(object);
 			tmp->next  = objectlist;
 			objectlist = tmp;
 		}
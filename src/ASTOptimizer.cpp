@@ -0,0 +1,282 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <climits>
+
+#include "TokenNamespace.h"
+#include "ASTOptimizer.h"
+#include "string.h"
+
+// #define PRINT_FOLDED_NODES
+
+bool _ast_fold_enabled = 1;
+
+
+// Literal constructors.
+// Replacement is allocated in the arena of the folded node.
+
+static ASTNode *integerNode(ASTNode *node, int value) {
+	Arena *arena    = ASTNode::arenaOf(node);
+	ASTNode *folded = new (arena) ASTNode(node->lineno, INTEGER);
+	folded->addLastObject(astObject<int>(arena, value));
+	return folded;
+};
+
+static ASTNode *booleanNode(ASTNode *node, bool value) {
+	Arena *arena    = ASTNode::arenaOf(node);
+	ASTNode *folded = new (arena) ASTNode(node->lineno, BOOLEAN);
+	folded->addLastObject(astObject<bool>(arena, value));
+	return folded;
+};
+
+// Literal accessors
+
+#define INTV(node)    (*(int*)    (node)->objectlist->object)
+#define BOOLV(node)   (*(bool*)   (node)->objectlist->object)
+#define STRINGV(node) ( (string*) (node)->objectlist->object)
+
+// Integer arithmetic as done by hardware, without signed overflow UB
+#define WRAP(a, op, b) ((int) ((unsigned int) (a) op (unsigned int) (b)))
+
+
+// Fold INTEGER op INTEGER. Mirrors Integer.cpp.
+// <= and << are not folded because integer_prototype
+// has no __operator<= and maps __operator<< to division.
+static ASTNode *foldInteger(ASTNode *node, int a, int b) {
+	switch (node->type) {
+		case EQ:     return booleanNode(node, a == b);
+		case NEQ:    return booleanNode(node, a != b);
+		case GT:     return booleanNode(node, a >  b);
+		case LT:     return booleanNode(node, a <  b);
+		case GE:     return booleanNode(node, a >= b);
+		case AND:    return booleanNode(node, a && b);
+		case OR:     return booleanNode(node, a || b);
+		case PLUS:   return integerNode(node, WRAP(a, +, b));
+		case MINUS:  return integerNode(node, WRAP(a, -, b));
+		case MUL:    return integerNode(node, WRAP(a, *, b));
+		case BITAND: return integerNode(node, a & b);
+		case BITOR:  return integerNode(node, a | b);
+		case BITXOR: return integerNode(node, a ^ b);
+
+		// Division by zero raises error in runtime
+		case DIV:
+			if (b == 0 || (a == INT_MIN && b == -1))
+				return NULL;
+			return integerNode(node, a / b);
+
+		// Modulo by zero gives undefined in runtime
+		case MOD:
+			if (b == 0 || (a == INT_MIN && b == -1))
+				return NULL;
+			return integerNode(node, a % b);
+
+		case BITRSH:
+			if (b < 0 || b > 31)
+				return NULL;
+			return integerNode(node, a >> b);
+
+		case BITURSH:
+			if (b < 0 || b > 31)
+				return NULL;
+			return integerNode(node, (int) ((unsigned int) a >> b));
+
+		default:
+			return NULL;
+	}
+};
+
+// Fold BOOLEAN op BOOLEAN. Mirrors Boolean.cpp.
+static ASTNode *foldBoolean(ASTNode *node, bool a, bool b) {
+	switch (node->type) {
+		case EQ:     return booleanNode(node, !a == !b);
+		case NEQ:
+		case BITXOR: return booleanNode(node, !a != !b);
+		case AND:
+		case BITAND: return booleanNode(node, a && b);
+		case OR:
+		case BITOR:  return booleanNode(node, a || b);
+
+		default:
+			return NULL;
+	}
+};
+
+// Fold unary operator on literal. Mirrors __operator!x / ~x / -x / +x.
+static ASTNode *foldUnary(ASTNode *node, ASTNode *value) {
+	if (value->type == INTEGER) {
+		int a = INTV(value);
+
+		switch (node->type) {
+			case NOT:    return integerNode(node, !a);
+			case BITNOT: return integerNode(node, ~a);
+			case NEG:    return integerNode(node, WRAP(0, -, a));
+			case POS:    return integerNode(node, a);
+		}
+	} else if (value->type == BOOLEAN) {
+		if (node->type == NOT)
+			return booleanNode(node, !BOOLV(value));
+	}
+
+	return NULL;
+};
+
+// Fold binary operator on literals.
+// DOUBLE is not folded: objectDoubleValue has no DOUBLE case,
+// so runtime Double operators differ from C arithmetic.
+static ASTNode *foldBinary(ASTNode *node, ASTNode *a, ASTNode *b) {
+	if (a->type != b->type)
+		return NULL;
+
+	switch (a->type) {
+		case INTEGER:
+			return foldInteger(node, INTV(a), INTV(b));
+
+		case BOOLEAN:
+			return foldBoolean(node, BOOLV(a), BOOLV(b));
+
+		case STRING: {
+			if (node->type != PLUS)
+				return NULL;
+
+			string s(STRINGV(a));
+			s += *STRINGV(b);
+			
+			Arena *arena    = ASTNode::arenaOf(node);
+			ASTNode *folded = new (arena) ASTNode(node->lineno, STRING);
+			folded->addLastObject(astString(arena, s.buffer, s.length));
+			return folded;
+		}
+
+		default:
+			return NULL;
+	}
+};
+
+// Returns 1 if node is constant condition, stores it's value in result
+static bool constantCondition(ASTNode *node, bool *result) {
+	if (node->type == INTEGER) {
+		*result = INTV(node);
+		return 1;
+	}
+	if (node->type == BOOLEAN) {
+		*result = BOOLV(node);
+		return 1;
+	}
+	return 0;
+};
+
+// Returns folded replacement for the node or the node itself.
+// Replacement must not be linked into the node subtree,
+// the caller deletes replaced node.
+static ASTNode *fold(ASTNode *node) {
+	// Fold children first, relinking replaced nodes
+	ASTNode *prev  = NULL;
+	ASTNode *child = node->left;
+
+	while (child) {
+		ASTNode *next   = child->next;
+		ASTNode *folded = fold(child);
+
+		if (folded != child) {
+			folded->next = next;
+
+			if (prev)
+				prev->next = folded;
+			else
+				node->left = folded;
+
+			if (node->right == child)
+				node->right = folded;
+
+			child->next = NULL;
+			delete child;
+		}
+
+		prev  = folded;
+		child = next;
+	}
+
+	ASTNode *folded = NULL;
+
+	switch (node->type) {
+		case NOT:
+		case BITNOT:
+		case NEG:
+		case POS:
+			folded = foldUnary(node, node->left);
+			break;
+
+		case EQ:     case NEQ:
+		case GT:     case GE:
+		case LT:     case LE:
+		case AND:    case OR:
+		case BITAND: case BITOR:  case BITXOR:
+		case BITRSH: case BITLSH: case BITURSH:
+		case PLUS:   case MINUS:
+		case MUL:    case DIV:
+		case MDIV:   case MOD:
+			folded = foldBinary(node, node->left, node->left->next);
+			break;
+
+		// Prune branch of IF / CONDITION with constant condition.
+		// IF always has else node (EMPTY if missing).
+		case IF:
+		case CONDITION: {
+			bool value;
+			if (!constantCondition(node->left, &value))
+				break;
+
+			ASTNode *branch = node->left->next;
+			ASTNode *other  = branch->next;
+
+			if (!value) {
+				ASTNode *tmp = branch;
+				branch       = other;
+				other        = tmp;
+			}
+
+			// Unlink taken branch, the rest is deleted with the node
+			node->left->next = other;
+			other->next      = NULL;
+			node->right      = other;
+			branch->next     = NULL;
+
+			folded = branch;
+			break;
+		}
+	}
+
+	if (!folded)
+		return node;
+
+#ifdef PRINT_FOLDED_NODES
+	printf("Folded node %d at line %d into %d\n", node->type, node->lineno, folded->type);
+#endif
+
+	return folded;
+};
+
+ASTNode *optimizeAST(ASTNode *root) {
+	if (!root || !_ast_fold_enabled)
+		return root;
+
+	fold(root);
+
+	return root;
+};
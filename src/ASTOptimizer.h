@@ -0,0 +1,38 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Optimization pass over parsed AST.
+ * Runs between Parser::parse and ASTExecuter::begin.
+ * Folds literal-only expressions on INTEGER, STRING, BOOLEAN
+ * following semantics of the builtin operators and prunes IF / CONDITION
+ * branches with constant condition.
+ */
+
+#ifndef AST_OPTIMIZER_H
+#define AST_OPTIMIZER_H
+
+#include "ASTNode.h"
+
+// set to 0 to disable constant folding (ck --no-fold)
+extern bool _ast_fold_enabled;
+
+// Fold constant subtrees of the given tree in place.
+// Returns root of the tree.
+ASTNode *optimizeAST(ASTNode *root);
+
+#endif
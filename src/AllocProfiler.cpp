@@ -0,0 +1,418 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+
+#include "AllocProfiler.h"
+#include "ASTExecuter.h"
+#include "GarbageCollector.h"
+
+#include "objects/Object.h"
+#include "objects/Array.h"
+#include "objects/Integer.h"
+#include "objects/Double.h"
+#include "objects/StringType.h"
+
+const char *tokenToString(int token);
+
+bool _alloc_profiler_enabled = 0;
+
+// Objects of type, freed by GC. Live objects are counted on report.
+struct AllocType {
+	long long freed;
+	long long freed_bytes;
+	long long live;
+	long long live_bytes;
+};
+
+// Interned file name
+struct AllocFile {
+	AllocFile   *next;
+	unsigned int hash;
+	string       path;
+	char        *name;
+};
+
+// Root / lock and amount of objects reachable only through it
+struct AllocRetainer {
+	AllocSite *site;
+	int        type;
+	long long  objects;
+	long long  bytes;
+};
+
+static AllocSite   *alloc_sites[ALLOC_PROFILER_TABLE_SIZE];
+static int          alloc_sites_count = 0;
+static AllocFile   *alloc_files       = NULL;
+// Last entry is used for objects of unknown type
+static AllocType    alloc_types[ALLOC_PROFILER_TYPES + 1];
+static ASTExecuter *alloc_executer    = NULL;
+
+static long long    alloc_cycles           = 0;
+static long long    alloc_cycle_survivors  = 0;
+static long long    alloc_last_survivors   = 0;
+static long long    alloc_max_survivors    = 0;
+
+// Returns type index of the object in alloc_types
+static int objectType(GC_Object *o) {
+	VirtualObject *v = dynamic_cast<VirtualObject*>(o);
+	if (v && v->type >= 0 && v->type < ALLOC_PROFILER_TYPES)
+		return v->type;
+	return ALLOC_PROFILER_TYPES;
+};
+
+static const char *typeName(int type, char *buffer, int size) {
+	if (type == ALLOC_PROFILER_TYPES)
+		return "<other>";
+	
+	return typeToString(type, buffer, size);
+};
+
+static const char *internFile(string *path) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < path->length; ++i) {
+		h ^= (unsigned int) path->buffer[i];
+		h *= 16777619u;
+	}
+	
+	for (AllocFile *f = alloc_files; f; f = f->next)
+		if (f->hash == h && f->path.length == path->length && !wmemcmp(f->path.buffer, path->buffer, path->length))
+			return f->name;
+	
+	AllocFile *f = new AllocFile;
+	f->hash      = h;
+	f->path      = *path;
+	f->name      = path->toCString();
+	f->next      = alloc_files;
+	alloc_files  = f;
+	return f->name;
+};
+
+static AllocSite *site(const char *file, int lineno) {
+	unsigned int h = ((unsigned long) file * 31 + lineno) % ALLOC_PROFILER_TABLE_SIZE;
+	
+	for (AllocSite *s = alloc_sites[h]; s; s = s->next)
+		if (s->file == file && s->lineno == lineno)
+			return s;
+	
+	AllocSite *s   = (AllocSite*) calloc(1, sizeof(AllocSite));
+	s->file        = file;
+	s->lineno      = lineno;
+	s->next        = alloc_sites[h];
+	alloc_sites[h] = s;
+	++alloc_sites_count;
+	return s;
+};
+
+// Site of the currently executed node
+static AllocSite *currentSite() {
+	int lineno = -1;
+	for (ASTExecuterElement *e = alloc_executer->aststack->head; e; e = e->next)
+		if (e->attached_node) {
+			lineno = e->attached_node->lineno;
+			break;
+		}
+	
+	const char *file = "<native>";
+	ASTExecuterStackTraceElement *t = alloc_executer->aststacktrace->head;
+	for (int i = 0; t && i < alloc_executer->aststacktrace->pos_size; ++i, t = t->next)
+		if (t->type == ASTESTE_FILE) {
+			file = internFile(&t->tracename);
+			break;
+		}
+	
+	return site(file, lineno);
+};
+
+void alloc_profiler_start(ASTExecuter *executer) {
+	alloc_executer          = executer;
+	_alloc_profiler_enabled = 1;
+};
+
+void alloc_profiler_attach(GC_Object *o) {
+	if (!alloc_executer->aststack->head)
+		return;
+	
+	AllocSite *s = currentSite();
+	o->gc_site   = s;
+	++s->count;
+	++s->live;
+	s->bytes      += o->gc_bytes;
+	s->live_bytes += o->gc_bytes;
+};
+
+void alloc_profiler_free(GC_Object *o) {
+	AllocSite *s = o->gc_site;
+	o->gc_site   = NULL;
+	--s->live;
+	s->live_bytes -= o->gc_bytes;
+	
+	// Type is unknown if called from ~GC_Object
+	AllocType *t = &alloc_types[objectType(o)];
+	++t->freed;
+	t->freed_bytes += o->gc_bytes;
+};
+
+void alloc_profiler_survived(GC_Object *o) {
+	++o->gc_site->survived;
+	++alloc_cycle_survivors;
+};
+
+void alloc_profiler_cycle() {
+	++alloc_cycles;
+	alloc_last_survivors  = alloc_cycle_survivors;
+	if (alloc_cycle_survivors > alloc_max_survivors)
+		alloc_max_survivors = alloc_cycle_survivors;
+	alloc_cycle_survivors = 0;
+};
+
+// Counts live tagged objects per type
+static void countLive() {
+	for (int i = 0; i <= ALLOC_PROFILER_TYPES; ++i)
+		alloc_types[i].live = alloc_types[i].live_bytes = 0;
+	
+	for (GC_Chain *c = GC.gc_objects; c; c = c->next)
+		if (!c->deleted_ptr && c->object->gc_site) {
+			AllocType *t = &alloc_types[objectType(c->object)];
+			++t->live;
+			t->live_bytes += c->object->gc_bytes;
+		}
+};
+
+// Marks roots & locks one by one, objects are retained by 
+// the first root that reaches them. Returns amount of retainers.
+static int computeRetainers(AllocRetainer **result) {
+	int size = 0;
+	for (GC_Chain *c = GC.gc_roots; c; c = c->next)
+		++size;
+	for (GC_Chain *c = GC.gc_locks; c; c = c->next)
+		++size;
+	
+	AllocRetainer *retainers = (AllocRetainer*) calloc(size + 1, sizeof(AllocRetainer));
+	int count                = 0;
+	long long reached        = 0;
+	long long reached_bytes  = 0;
+	
+	for (int pass = 0; pass < 2; ++pass)
+		for (GC_Chain *c = pass ? GC.gc_locks : GC.gc_roots; c; c = c->next) {
+			if (c->deleted_ptr || !(pass ? c->object->gc_lock : c->object->gc_root))
+				continue;
+			
+			c->object->mark();
+			
+			long long total       = 0;
+			long long total_bytes = 0;
+			for (GC_Chain *o = GC.gc_objects; o; o = o->next)
+				if (!o->deleted_ptr && o->object->gc_reachable) {
+					++total;
+					total_bytes += o->object->gc_bytes;
+				}
+			
+			if (total == reached)
+				continue;
+			
+			AllocSite *s = c->object->gc_site;
+			int type     = objectType(c->object);
+			int i        = 0;
+			while (i < count && (retainers[i].site != s || retainers[i].type != type))
+				++i;
+			
+			if (i == count) {
+				retainers[i].site = s;
+				retainers[i].type = type;
+				++count;
+			}
+			
+			retainers[i].objects += total - reached;
+			retainers[i].bytes   += total_bytes - reached_bytes;
+			reached               = total;
+			reached_bytes         = total_bytes;
+		}
+	
+	for (GC_Chain *o = GC.gc_objects; o; o = o->next)
+		if (!o->deleted_ptr)
+			o->object->gc_reachable = 0;
+	
+	*result = retainers;
+	return count;
+};
+
+static int compareSites(const void *a, const void *b) {
+	AllocSite *x = *(AllocSite**) a;
+	AllocSite *y = *(AllocSite**) b;
+	
+	if (x->live_bytes != y->live_bytes)
+		return x->live_bytes < y->live_bytes ? 1 : -1;
+	if (x->bytes != y->bytes)
+		return x->bytes < y->bytes ? 1 : -1;
+	return 0;
+};
+
+static int compareRetainers(const void *a, const void *b) {
+	AllocRetainer *x = (AllocRetainer*) a;
+	AllocRetainer *y = (AllocRetainer*) b;
+	
+	if (x->bytes != y->bytes)
+		return x->bytes < y->bytes ? 1 : -1;
+	return 0;
+};
+
+// Returns sites sorted by live bytes
+static AllocSite **sortedSites() {
+	AllocSite **sites = (AllocSite**) malloc((alloc_sites_count + 1) * sizeof(AllocSite*));
+	int count = 0;
+	for (int i = 0; i < ALLOC_PROFILER_TABLE_SIZE; ++i)
+		for (AllocSite *s = alloc_sites[i]; s; s = s->next)
+			sites[count++] = s;
+	
+	qsort(sites, count, sizeof(AllocSite*), compareSites);
+	return sites;
+};
+
+static const char *siteFile(AllocSite *s) {
+	return s ? s->file : "<untracked>";
+};
+
+static int siteLine(AllocSite *s) {
+	return s ? s->lineno : -1;
+};
+
+void alloc_profiler_report(FILE *out) {
+	char buffer[32];
+	
+	countLive();
+	
+	AllocRetainer *retainers;
+	int nretainers    = computeRetainers(&retainers);
+	qsort(retainers, nretainers, sizeof(AllocRetainer), compareRetainers);
+	
+	AllocSite **sites = sortedSites();
+	
+	long long count = 0, bytes = 0, live = 0, live_bytes = 0;
+	for (int i = 0; i < alloc_sites_count; ++i) {
+		count      += sites[i]->count;
+		bytes      += sites[i]->bytes;
+		live       += sites[i]->live;
+		live_bytes += sites[i]->live_bytes;
+	}
+	
+	fprintf(out, "\nAllocations: %lld objects, %lld bytes, live: %lld objects, %lld bytes\n", count, bytes, live, live_bytes);
+	fprintf(out, "GC cycles: %lld, survivors of last cycle: %lld, max: %lld\n", alloc_cycles, alloc_last_survivors, alloc_max_survivors);
+	
+	fprintf(out, "\nSites: %d\n", alloc_sites_count);
+	fprintf(out, "%12s %14s %12s %14s %12s  %s\n", "count", "bytes", "live", "live bytes", "survived", "site");
+	for (int i = 0; i < alloc_sites_count && i < ALLOC_PROFILER_TOP; ++i)
+		fprintf(out, "%12lld %14lld %12lld %14lld %12lld  %s:%d\n", sites[i]->count, sites[i]->bytes, 
+			sites[i]->live, sites[i]->live_bytes, sites[i]->survived, sites[i]->file, sites[i]->lineno);
+	
+	fprintf(out, "\nTypes:\n");
+	fprintf(out, "%-20s %12s %14s %12s %14s\n", "type", "count", "bytes", "live", "live bytes");
+	for (int i = 0; i <= ALLOC_PROFILER_TYPES; ++i) {
+		AllocType *t = &alloc_types[i];
+		if (t->freed || t->live)
+			fprintf(out, "%-20s %12lld %14lld %12lld %14lld\n", typeName(i, buffer, sizeof(buffer)),
+				t->freed + t->live, t->freed_bytes + t->live_bytes, t->live, t->live_bytes);
+	}
+	
+	fprintf(out, "\nRetainers:\n");
+	fprintf(out, "%-20s %12s %14s  %s\n", "type", "objects", "bytes", "site");
+	for (int i = 0; i < nretainers && i < ALLOC_PROFILER_TOP; ++i)
+		fprintf(out, "%-20s %12lld %14lld  %s:%d\n", typeName(retainers[i].type, buffer, sizeof(buffer)), 
+			retainers[i].objects, retainers[i].bytes, siteFile(retainers[i].site), siteLine(retainers[i].site));
+	
+	free(sites);
+	free(retainers);
+};
+
+static void put(Object *o, const char *key, VirtualObject *value) {
+	o->table->put(string(key), value);
+};
+
+VirtualObject *alloc_profiler_object() {
+	char buffer[32];
+	
+	countLive();
+	
+	AllocRetainer *retainers;
+	int nretainers    = computeRetainers(&retainers);
+	qsort(retainers, nretainers, sizeof(AllocRetainer), compareRetainers);
+	
+	AllocSite **sites = sortedSites();
+	
+	Object *result = new Object;
+	
+	Array *array = new Array;
+	put(result, "sites", array);
+	for (int i = 0; i < alloc_sites_count; ++i) {
+		Object *o = new Object;
+		put(o, "file",      new String(sites[i]->file));
+		put(o, "line",      new Integer(sites[i]->lineno));
+		put(o, "count",     new Double(sites[i]->count));
+		put(o, "bytes",     new Double(sites[i]->bytes));
+		put(o, "live",      new Double(sites[i]->live));
+		put(o, "liveBytes", new Double(sites[i]->live_bytes));
+		put(o, "survived",  new Double(sites[i]->survived));
+		array->array->push(o);
+	}
+	
+	array = new Array;
+	put(result, "types", array);
+	for (int i = 0; i <= ALLOC_PROFILER_TYPES; ++i) {
+		AllocType *t = &alloc_types[i];
+		if (!t->freed && !t->live)
+			continue;
+		
+		Object *o = new Object;
+		put(o, "type",      new String(typeName(i, buffer, sizeof(buffer))));
+		put(o, "count",     new Double(t->freed + t->live));
+		put(o, "bytes",     new Double(t->freed_bytes + t->live_bytes));
+		put(o, "live",      new Double(t->live));
+		put(o, "liveBytes", new Double(t->live_bytes));
+		array->array->push(o);
+	}
+	
+	array = new Array;
+	put(result, "retainers", array);
+	for (int i = 0; i < nretainers; ++i) {
+		Object *o = new Object;
+		put(o, "type",    new String(typeName(retainers[i].type, buffer, sizeof(buffer))));
+		put(o, "file",    new String(siteFile(retainers[i].site)));
+		put(o, "line",    new Integer(siteLine(retainers[i].site)));
+		put(o, "objects", new Double(retainers[i].objects));
+		put(o, "bytes",   new Double(retainers[i].bytes));
+		array->array->push(o);
+	}
+	
+	put(result, "cycles",    new Integer(alloc_cycles));
+	put(result, "survivors", new Integer(alloc_last_survivors));
+	
+	free(sites);
+	free(retainers);
+	
+	return result;
+};
+
+void alloc_profiler_stop() {
+	if (!_alloc_profiler_enabled)
+		return;
+	
+	alloc_profiler_report(stderr);
+	_alloc_profiler_enabled = 0;
+};
@@ -0,0 +1,84 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Allocation-site profiler (ck --alloc-profile).
+ * Every GC_Object created while enabled is tagged with the file & line 
+ * of the executed node. Sites count total / live objects & bytes and 
+ * amount of GC cycles survived by their objects. 
+ * Report is printed on exit and returned by GC.allocationProfile().
+ */
+
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+#include <cstdio>
+
+// Amount of buckets in site table
+#define ALLOC_PROFILER_TABLE_SIZE 4096
+// Amount of tracked object types
+#define ALLOC_PROFILER_TYPES      256
+// Amount of rows printed in each table of report
+#define ALLOC_PROFILER_TOP        20
+
+struct GC_Object;
+struct ASTExecuter;
+struct VirtualObject;
+
+struct AllocSite {
+	AllocSite *next;
+	// Interned file name
+	const char *file;
+	int       lineno;
+	
+	long long  count;
+	long long  bytes;
+	long long  live;
+	long long  live_bytes;
+	// Sum of GC cycles survived by objects of this site
+	long long  survived;
+};
+
+// 1 if new objects are tagged
+extern bool _alloc_profiler_enabled;
+
+// Starts tagging objects allocated by scripts of the executer
+void alloc_profiler_start(ASTExecuter *executer);
+
+// Prints report to stderr & stops tagging
+void alloc_profiler_stop();
+
+// Tags new object with current site
+void alloc_profiler_attach(GC_Object *o);
+
+// Object of the site is destroyed
+void alloc_profiler_free(GC_Object *o);
+
+// Object of the site survived GC cycle
+void alloc_profiler_survived(GC_Object *o);
+
+// Called after each GC cycle
+void alloc_profiler_cycle();
+
+// Writes report tables
+void alloc_profiler_report(FILE *out);
+
+// Builds report as script object:
+// { sites: [...], types: [...], retainers: [...], cycles, survivors }
+VirtualObject *alloc_profiler_object();
+
+#endif
@@ -0,0 +1,101 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Bump allocator for data of known lifetime
+ * (tokens of the parsed file, AST). Memory is taken from chunks 
+ * and released all at once on clear() / destruction, 
+ * destructors of allocated objects are not called.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+// Default size of arena chunk in bytes
+#define ARENA_CHUNK_SIZE 65536
+// Alignment of allocated blocks
+#define ARENA_ALIGN      8
+
+struct ArenaChunk {
+	ArenaChunk *next;
+	size_t      size;
+	size_t      used;
+	
+	char *data() {
+		return (char*) (this + 1);
+	};
+};
+
+struct Arena {
+	ArenaChunk *head;
+	size_t      chunk_size;
+	// Total size of chunks
+	size_t      allocated;
+	
+	Arena(size_t chunk_size = ARENA_CHUNK_SIZE) {
+		this->head       = NULL;
+		this->chunk_size = chunk_size;
+		this->allocated  = 0;
+	};
+	
+	~Arena() {
+		clear();
+	};
+	
+	// Returns uninitialized block of given size
+	void *alloc(size_t size) {
+		size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+		
+		if (!head || head->used + size > head->size) {
+			// Large blocks get own chunk
+			size_t csize     = size > chunk_size ? size : chunk_size;
+			ArenaChunk *c    = (ArenaChunk*) malloc(sizeof(ArenaChunk) + csize);
+			c->size          = csize;
+			c->used          = 0;
+			allocated       += csize;
+			
+			// Keep partially used chunk on top
+			if (head && size > chunk_size) {
+				c->next    = head->next;
+				head->next = c;
+				c->used    = size;
+				return c->data();
+			}
+			
+			c->next = head;
+			head    = c;
+		}
+		
+		void *p     = head->data() + head->used;
+		head->used += size;
+		return p;
+	};
+	
+	// Releases all chunks
+	void clear() {
+		while (head) {
+			ArenaChunk *c = head->next;
+			free(head);
+			head = c;
+		}
+		allocated = 0;
+	};
+};
+
+#endif
@@ -35,9 +35,18 @@
 #include "objects/ObjectConverter.h"
 
 #include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <sys/stat.h>
 #include "string.h"
 #include "ptr_wrapper.h"
 #include "Parser.h"
+#include "ASTOptimizer.h"
+#include "ASTCache.h"
+#include "ImportPrefetch.h"
+#include "Tracer.h"
+#include "AllocProfiler.h"
+#include "HeapSnapshot.h"
 
 #include "exec_state.h"
 
@@ -64,23 +73,327 @@ static VirtualObject* function_GC_collect(Scope *scope, int argc, VirtualObject
 	return NULL;
 };
 
+// Returns report of allocation profiler / undefined if not enabled
+static VirtualObject* function_GC_allocationProfile(Scope *scope, int argc, VirtualObject **args) {	
+	if (!_alloc_profiler_enabled)
+		return new Undefined;
+	return alloc_profiler_object();
+};
+
+// stats() - telemetry of collections, pauses are in nanoseconds.
+// Counters are 64-bit and returned as Double.
+static VirtualObject* function_GC_stats(Scope *scope, int argc, VirtualObject **args) {	
+	GC_Stats stats = GC.gc_stats;
+	Object *result = new Object;
+	result->table->put(string("cycles"),        new Double(stats.cycles));
+	result->table->put(string("pauseTotalNs"),  new Double(stats.pause_total_ns));
+	result->table->put(string("pauseMaxNs"),    new Double(stats.pause_max_ns));
+	result->table->put(string("objectsFreed"),  new Double(stats.objects_freed));
+	result->table->put(string("bytesFreed"),    new Double(stats.bytes_freed));
+	result->table->put(string("rootsScanned"),  new Double(stats.roots_scanned));
+	result->table->put(string("locksScanned"),  new Double(stats.locks_scanned));
+	
+	Array *pauses = new Array;
+	for (int i = 0; i < GC_PAUSE_BUCKETS; ++i)
+		pauses->array->push(new Double(stats.pauses[i]));
+	result->table->put(string("pauseHistogram"), pauses);
+	
+	return result;
+};
+
+// snapshot(path) - writes heap graph, returns true on success
+static VirtualObject* function_GC_snapshot(Scope *scope, int argc, VirtualObject **args) {	
+	if (!argc)
+		return new Boolean(0);
+	
+	string path = objectStringValue(args[0]);
+	ptr_wrapper wrapper(path.toCString(), PTR_ALLOC);
+	return new Boolean(heap_snapshot((char*) wrapper.ptr));
+};
+
+// census() - amount of objects & bytes per type
+static VirtualObject* function_GC_census(Scope *scope, int argc, VirtualObject **args) {	
+	return heap_census();
+};
+
+static void define_GC_members(Object *GC_Obj) {
+	GC_Obj->table->put(string("numObjects"),        new NativeFunction(&function_GC_numobjects));
+	GC_Obj->table->put(string("numRoots"),          new NativeFunction(&function_GC_numroots));
+	GC_Obj->table->put(string("collect"),           new NativeFunction(&function_GC_collect));
+	GC_Obj->table->put(string("allocationProfile"), new NativeFunction(&function_GC_allocationProfile));
+	GC_Obj->table->put(string("snapshot"),          new NativeFunction(&function_GC_snapshot));
+	GC_Obj->table->put(string("census"),            new NativeFunction(&function_GC_census));
+	GC_Obj->table->put(string("stats"),             new NativeFunction(&function_GC_stats));
+};
+
 static void define_GC(Scope *scope) {
-	Object *GC_Obj = new Object;
-	GC_Obj->table->put(string("numObjects"), new NativeFunction(&function_GC_numobjects));
-	GC_Obj->table->put(string("numRoots"),   new NativeFunction(&function_GC_numroots));
-	GC_Obj->table->put(string("collect"),    new NativeFunction(&function_GC_collect));
+	scope->table->put(string("GC"), new LazyObject(&define_GC_members));
+};
+
+
+// - - - - - - - - - P E R F
+
+
+// Default options of Perf.bench
+#define PERF_BENCH_WARMUP      3
+#define PERF_BENCH_SAMPLES     10
+#define PERF_BENCH_SAMPLE_TIME 50
+// Max amount of calls in single sample
+#define PERF_BENCH_MAX_CALLS   1000000
+
+static double perf_clock(clockid_t clock) {
+	struct timespec t;
+	clock_gettime(clock, &t);
+	return t.tv_sec * 1000000000.0 + t.tv_nsec;
+};
+
+// now() - monotonic time in nanoseconds
+static VirtualObject* function_Perf_now(Scope *scope, int argc, VirtualObject **args) {	
+	return new Double(perf_clock(CLOCK_MONOTONIC));
+};
+
+// cpuTime() - CPU time of the process in nanoseconds
+static VirtualObject* function_Perf_cpuTime(Scope *scope, int argc, VirtualObject **args) {	
+	return new Double(perf_clock(CLOCK_PROCESS_CPUTIME_ID));
+};
+
+// Integer option of the Perf.bench options object
+static int perf_option(VirtualObject *options, const char *name, int def) {
+	if (!options || options->type != OBJECT)
+		return def;
 	
-	scope->table->put(string("GC"), GC_Obj);
+	VirtualObject *value = ((Object*) options)->table->get(string(name));
+	if (!value || (value->type != INTEGER && value->type != DOUBLE))
+		return def;
+	
+	return objectIntValue(value);
+};
+
+// Calls function n times, returns 0 if it raised error
+static bool perf_calls(ASTExecuter *executer, Scope *scope, VirtualObject *function, long n, VirtualObject **error) {
+	for (long i = 0; i < n; ++i) {
+		ExecuterResult result = executer->beginFunction(scope, NULL, function, 0);
+		if (result.type == ERT_ERROR) {
+			*error = result.object;
+			return 0;
+		}
+	}
+	return 1;
+};
+
+// Disposes executer of the bench & raises error of the function in the caller
+static VirtualObject* perf_raise(Scope *scope, ASTExecuter *executer, VirtualObject *error) {
+	// Executer collects garbage on dispose
+	GC.gc_lock(error);
+	delete executer;
+	GC.gc_unlock(error);
+	
+	scope->context->executer->raiseError(error);
+	return new Undefined;
+};
+
+static int perf_compare(const void *a, const void *b) {
+	double x = *(double*) a;
+	double y = *(double*) b;
+	return x < y ? -1 : x > y;
+};
+
+// bench(function[, {warmup, samples, sampleTime, iterations}])
+// Calls function warmup times, calibrates amount of calls per sample
+// to take at least sampleTime milliseconds (unless iterations is given) 
+// & measures given amount of samples.
+// Times in the result are in nanoseconds per call.
+static VirtualObject* function_Perf_bench(Scope *scope, int argc, VirtualObject **args) {	
+	if (!argc || !args[0] || (args[0]->type != CODE_FUNCTION && args[0]->type != NATIVE_FUNCTION)) {
+		scope->context->executer->raiseError("Perf.bench expects function");
+		return new Undefined;
+	}
+	
+	VirtualObject *function = args[0];
+	VirtualObject *options  = argc > 1 ? args[1] : NULL;
+	
+	int warmup      = perf_option(options, "warmup",     PERF_BENCH_WARMUP);
+	int samples     = perf_option(options, "samples",    PERF_BENCH_SAMPLES);
+	int sample_time = perf_option(options, "sampleTime", PERF_BENCH_SAMPLE_TIME);
+	long calls      = perf_option(options, "iterations", 0);
+	
+	if (samples < 1)
+		samples = 1;
+	
+	ASTExecuter *executer = new ASTExecuter;
+	if (function->type == CODE_FUNCTION)
+		executer->insertStackTrace(((CodeFunction*) function)->scope->context->executer);
+	else 
+		executer->aststacktrace->insert(string("virtual"));
+	
+	VirtualObject *error = NULL;
+	
+	if (!perf_calls(executer, scope, function, warmup, &error))
+		return perf_raise(scope, executer, error);
+	
+	// Grow amount of calls till sample takes sampleTime
+	if (calls < 1) {
+		calls = 1;
+		while (calls < PERF_BENCH_MAX_CALLS) {
+			double start = perf_clock(CLOCK_MONOTONIC);
+			if (!perf_calls(executer, scope, function, calls, &error))
+				return perf_raise(scope, executer, error);
+			double time = perf_clock(CLOCK_MONOTONIC) - start;
+			
+			if (time >= sample_time * 1000000.0)
+				break;
+			
+			long next = time > 0 ? (long) (calls * sample_time * 1000000.0 / time) + 1 : calls * 10;
+			calls     = next > calls * 10 ? calls * 10 : next > calls ? next : calls + 1;
+			if (calls > PERF_BENCH_MAX_CALLS)
+				calls = PERF_BENCH_MAX_CALLS;
+		}
+	}
+	
+	double *times = (double*) malloc(samples * sizeof(double));
+	GC_Stats gc   = GC.gc_stats;
+	
+	for (int i = 0; i < samples; ++i) {
+		double start = perf_clock(CLOCK_MONOTONIC);
+		if (!perf_calls(executer, scope, function, calls, &error)) {
+			free(times);
+			return perf_raise(scope, executer, error);
+		}
+		times[i] = (perf_clock(CLOCK_MONOTONIC) - start) / calls;
+	}
+	
+	GC_Stats after = GC.gc_stats;
+	delete executer;
+	
+	double mean = 0;
+	for (int i = 0; i < samples; ++i)
+		mean += times[i];
+	mean /= samples;
+	
+	double variance = 0;
+	for (int i = 0; i < samples; ++i)
+		variance += (times[i] - mean) * (times[i] - mean);
+	variance /= samples > 1 ? samples - 1 : 1;
+	
+	qsort(times, samples, sizeof(double), perf_compare);
+	double median = samples % 2 ? times[samples / 2] : (times[samples / 2 - 1] + times[samples / 2]) / 2;
+	
+	Object *result = new Object;
+	result->table->put(string("iterations"), new Integer(calls));
+	result->table->put(string("samples"),    new Integer(samples));
+	result->table->put(string("mean"),       new Double(mean));
+	result->table->put(string("median"),     new Double(median));
+	result->table->put(string("stddev"),     new Double(sqrt(variance)));
+	result->table->put(string("min"),        new Double(times[0]));
+	result->table->put(string("max"),        new Double(times[samples - 1]));
+	result->table->put(string("gcCycles"),   new Integer(after.cycles - gc.cycles));
+	result->table->put(string("gcPauseNs"),  new Double(after.pause_total_ns - gc.pause_total_ns));
+	result->table->put(string("gcFreed"),    new Integer(after.objects_freed - gc.objects_freed));
+	
+	free(times);
+	return result;
+};
+
+static void define_Perf_members(Object *Perf_Obj) {
+	Perf_Obj->table->put(string("now"),     new NativeFunction(&function_Perf_now));
+	Perf_Obj->table->put(string("cpuTime"), new NativeFunction(&function_Perf_cpuTime));
+	Perf_Obj->table->put(string("bench"),   new NativeFunction(&function_Perf_bench));
+};
+
+static void define_Perf(Scope *scope) {
+	scope->table->put(string("Perf"), new LazyObject(&define_Perf_members));
 };
 
 
 // - - - - - - - - - R U N T I M E
 
 
-// includeFile(filename[, Object:context])
+// Parsed tree of imported file.
+// Trees are kept until exit, functions declared 
+// by imported script refer to it's nodes.
+struct ImportedScript {
+	// Real path of the file
+	string                path;
+	ASTNode              *tree;
+	// State of the file when tree was parsed
+	unsigned long long   mtime;
+	long long             size;
+	// Set after first import
+	bool              imported;
+};
+
+VectorArray<ImportedScript> *imported_scripts = NULL;
+// Trees replaced after change of the file
+VectorArray<ASTNode>        *outdated_trees   = NULL;
+
+void dispose_imported_scripts() {
+	if (imported_scripts) {
+		for (int i = 0; i < imported_scripts->length; ++i) {
+			delete imported_scripts->vector[i]->tree;
+			delete imported_scripts->vector[i];
+		}
+		delete imported_scripts;
+		imported_scripts = NULL;
+	}
+	
+	if (outdated_trees) {
+		for (int i = 0; i < outdated_trees->length; ++i)
+			delete outdated_trees->vector[i];
+		delete outdated_trees;
+		outdated_trees = NULL;
+	}
+};
+
+static ImportedScript *findImportedScript(const char *path) {
+	if (!imported_scripts)
+		return NULL;
+	
+	string key(path);
+	for (int i = 0; i < imported_scripts->length; ++i)
+		if (imported_scripts->vector[i]->path == key)
+			return imported_scripts->vector[i];
+	return NULL;
+};
+
+// Parses the file, returns tree with type IMPORTED_SCRIPT / NULL
+static ASTNode *parseImportedScript(FileUrl *path) {
+	FILE *f = path->open("r");
+	if (!f)
+		return NULL;
+	
+	unsigned long long parse_start = _tracer_enabled ? tracer_now() : 0;
+	
+	FAKESTREAM  fs(f);
+	ASTNode *tree = ast_cache_load(path->path, fs.string, fs.length);
+	
+	if (!tree) {
+		TokenStream ts;
+		Parser       p;
+		ts.init(&fs);
+		p.init(&ts);
+		
+		tree = p.parse();
+		
+		if (!tree)
+			return NULL;
+		
+		optimizeAST(tree);
+		ast_cache_store(path->path, fs.string, fs.length, tree);
+	}
+	
+	if (_tracer_enabled)
+		tracer_complete(TRACER_PARSE, path->path, parse_start);
+	
+	tree->type = IMPORTED_SCRIPT;
+	return tree;
+};
+
+// importFile(filename[, Object:context]) / importOnce(filename[, Object:context])
 // This fucntion is macro, so it will NOT return any values.
 // This function is NOT expression-safe.
-static VirtualObject* function_Runtime_importFile(Scope *scope, int argc, VirtualObject **args) {	
+// Tree of the file is parsed once and reused while file mtime & size 
+// are not changed, once = 1 skips files that are already imported.
+static VirtualObject* importScript(Scope *scope, int argc, VirtualObject **args, bool once) {	
 	if (argc == 0 || !scope || !scope->context->executer)
 		return NULL;
 	
@@ -95,14 +408,11 @@ static VirtualObject* function_Runtime_importFile(Scope *scope, int argc, Virtua
 	FileUrl *filename = new FileUrl(cfilename);
 	free(cfilename);
 	
-	FILE *f = filename->open("r");
-	
-	if (!f) {
+	if (!filename->exists()) {
 		FileUrl *extendedfilepath = new FileUrl(scope->context->script_dir_path, filename);
 		delete filename;
-		f = extendedfilepath->open("r");
 		
-		if (!f) {
+		if (!extendedfilepath->exists()) {
 			delete extendedfilepath;
 			scope->context->executer->raiseError("File not found");
 			return NULL;
@@ -115,20 +425,62 @@ static VirtualObject* function_Runtime_importFile(Scope *scope, int argc, Virtua
 	delete env_file_path;
 	env_file_path = temp;
 	
-	FAKESTREAM  fs(f);
-	TokenStream ts;
-	Parser       p;
-	ts.init(&fs);
-	p.init(&ts);
+	struct stat st;
+	if (!env_file_path || stat(env_file_path->path, &st) != 0) {
+		delete env_file_path;
+		scope->context->executer->raiseError("File not found");
+		return NULL;
+	}
 	
-	ASTNode *tree = p.parse();
+#ifdef _WIN32
+	unsigned long long mtime = st.st_mtime * 1000000000ull;
+#else
+	unsigned long long mtime = st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+#endif
+	ImportedScript *script   = findImportedScript(env_file_path->path);
 	
-	if (!tree) {
-		scope->context->executer->raiseError("Parser error");
+	if (script && once && script->imported) {
+		delete env_file_path;
 		return NULL;
 	}
 	
-	tree->type = IMPORTED_SCRIPT;
+	if (!script || script->mtime != mtime || script->size != st.st_size) {
+		// Parsed in background with --prefetch-imports
+		ASTNode *tree = import_prefetch_take(env_file_path->path, mtime, st.st_size);
+		
+		if (tree)
+			tree->type = IMPORTED_SCRIPT;
+		else
+			tree = parseImportedScript(env_file_path);
+		
+		if (!tree) {
+			delete env_file_path;
+			scope->context->executer->raiseError("Parser error");
+			return NULL;
+		}
+		
+		if (!script) {
+			if (!imported_scripts)
+				imported_scripts = new VectorArray<ImportedScript>();
+			
+			script           = new ImportedScript;
+			script->path     = string(env_file_path->path);
+			script->imported = 0;
+			imported_scripts->push(script);
+		} else {
+			// Old tree may be still referenced by functions
+			if (!outdated_trees)
+				outdated_trees = new VectorArray<ASTNode>();
+			outdated_trees->push(script->tree);
+		}
+		
+		script->tree  = tree;
+		script->mtime = mtime;
+		script->size  = st.st_size;
+	}
+	
+	script->imported = 1;
+	ASTNode *tree    = script->tree;
 	
 	ASTExecuter *executer       = scope->context->executer;
 	Context     *base_context   = scope->context;
@@ -184,9 +536,21 @@ static VirtualObject* function_Runtime_importFile(Scope *scope, int argc, Virtua
 	element->target = tree->left;
 	executer->aststacktrace->push(executer->aststack->size, string(new_context->script_file_path->path));
 	
+	// Ends when IMPORTED_SCRIPT is left
+	if (_tracer_enabled)
+		tracer_begin(TRACER_IMPORT, new_context->script_file_path->path);
+	
 	return NULL;
 };
 
+static VirtualObject* function_Runtime_importFile(Scope *scope, int argc, VirtualObject **args) {	
+	return importScript(scope, argc, args, 0);
+};
+
+static VirtualObject* function_Runtime_importOnce(Scope *scope, int argc, VirtualObject **args) {	
+	return importScript(scope, argc, args, 1);
+};
+
 static VirtualObject* function_Runtime_exit(Scope *scope, int argc, VirtualObject **args) {	
 	if (argc == 0)
 		_interpreter_exit();
@@ -221,15 +585,17 @@ static VirtualObject* function_Runtime_defaultErrorHandler(Scope *scope, int arg
 	return NULL;
 };
 
-static void define_Runtime(Scope *scope) {
-	Object *Runtime_Obj = new Object;
+static void define_Runtime_members(Object *Runtime_Obj) {
 	Runtime_Obj->table->put(string("importFile"),          new NativeFunction(&function_Runtime_importFile));
+	Runtime_Obj->table->put(string("importOnce"),          new NativeFunction(&function_Runtime_importOnce));
 	Runtime_Obj->table->put(string("defaultErrorHandler"), new NativeFunction(&function_Runtime_defaultErrorHandler));
 	Runtime_Obj->table->put(string("defaultExitListener"), new NativeFunction(&function_default));
 	Runtime_Obj->table->put(string("exit"),                new NativeFunction(&function_Runtime_exit));
 	Runtime_Obj->table->put(string("system"),              new NativeFunction(&function_Runtime_system));
-	
-	scope->table->put(string("Runtime"), Runtime_Obj);
+};
+
+static void define_Runtime(Scope *scope) {
+	scope->table->put(string("Runtime"), new LazyObject(&define_Runtime_members));
 };
 
 
@@ -245,12 +611,13 @@ static VirtualObject* function_Context_getFile(Scope *scope, int argc, VirtualOb
 	return new String(scope->context->script_file_path->path);
 };
 
-void define_Context(Scope *scope) {
-	Object *Context_Obj = new Object;
+static void define_Context_members(Object *Context_Obj) {
 	Context_Obj->table->put(string("getPath"), new NativeFunction(&function_Context_getPath));
 	Context_Obj->table->put(string("getFile"), new NativeFunction(&function_Context_getFile));
-	
-	scope->table->put(string("Context"), Context_Obj);
+};
+
+void define_Context(Scope *scope) {
+	scope->table->put(string("Context"), new LazyObject(&define_Context_members));
 };
 
 
@@ -343,23 +710,23 @@ static VirtualObject* function_stdio_print(Scope *scope, int argc, VirtualObject
 	return new Integer(s.length);
 };
 
-static void define_stdio(Scope *scope) {
-	Object *stdio_Obj = new Object;
+static void define_stdio_members(Object *stdio_Obj) {
 	stdio_Obj->table->put(string("print"),      new NativeFunction(&function_stdio_print));
 	stdio_Obj->table->put(string("println"),    new NativeFunction(&function_stdio_println));
 	stdio_Obj->table->put(string("readln"),     new NativeFunction(&function_stdio_readln));
 	stdio_Obj->table->put(string("readInt"),    new NativeFunction(&function_stdio_readInt));
 	stdio_Obj->table->put(string("readDouble"), new NativeFunction(&function_stdio_readDouble));
 	stdio_Obj->table->put(string("read"),       new NativeFunction(&function_stdio_read));
-	
-	scope->table->put(string("stdio"), stdio_Obj);
+};
+
+static void define_stdio(Scope *scope) {
+	scope->table->put(string("stdio"), new LazyObject(&define_stdio_members));
 };
 
 
 // - - - - - - - - - P L A T F O R M
 
-static void define_Platform(Scope *scope) {
-	Object *Platform_Obj = new Object;
+static void define_Platform_members(Object *Platform_Obj) {
 	Platform_Obj->table->put(string("os_name"),      
 #if   defined_WIN32
 		new String("windows")
@@ -375,14 +742,17 @@ static void define_Platform(Scope *scope) {
 		new String("undefined")
 #endif
 	);
-	
-	scope->define(string("Platform"), Platform_Obj);
+};
+
+static void define_Platform(Scope *scope) {
+	scope->define(string("Platform"), new LazyObject(&define_Platform_members));
 };
 
 
 // Define all global functions & fields.
 static void define_global_fields(Scope *scope) {	
 	define_GC(scope);
+	define_Perf(scope);
 	define_Runtime(scope);
 	define_Context(scope);
 	define_stdio(scope);
@@ -28,4 +28,8 @@
 
 extern void defineTypes(Scope *root_scope);
 
+// Called on program exit.
+// Disposes trees of files imported by Runtime.importFile.
+extern void dispose_imported_scripts();
+
 #endif
\ No newline at end of file
@@ -20,6 +20,10 @@
  * STDIN
  * File read
  * String argument
+ *
+ * Source is decoded into single wide char buffer on construction,
+ * files are mapped into memory & decoded from UTF-8 in bulk.
+ * TokenStream scans text directly, getc() is left for other readers.
  */
 
 #ifndef FAKESTREAM_H
@@ -29,8 +33,16 @@
 #include <cstdlib>
 #include <wchar.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #define INVALID (-2)
 
+// Replaces invalid UTF-8 sequences
+#define UTF8_REPLACEMENT 0xFFFD
+
 enum FAKESTREAM_TYPE {
 	IN_STRING,
 	IN_FILE,
@@ -47,68 +59,119 @@ static wchar_t *charToWChar(const char *c) {
 	return wc;
 };
 
-/*
-
-		int i = 0;
-		printf("%d\n", this->string[i]);
-		while (this->string[i])
-			printf("%08X : '%lc'\n", this->string[i], this->string[i]), ++i;
-*/
-
-#ifdef _WIN32
-#include <fcntl.h>  
-#include <io.h>  
-#include <wchar.h>
-
-#define _O_U16TEXT 0x00020000
-
-static int fgetutf8c(FILE* f) {
-    int result = 0;
-    int input[6] = {};
-
-    input[0] = fgetc(f);
-    // printf("(i[0] = %d) ", input[0]);
-    if (input[0] == EOF) {
-        // The EOF was hit by the first character.
-        result = EOF;
-    }
-    else if (input[0] < 0x80) {
-        // the first character is the only 7 bit sequence...
-        result = input[0];
-    }
-    else if ((input[0] & 0xC0) == 0x80) {
-        // This is not the beginning of the multibyte sequence.
-        return INVALID;
-    }
-    else if ((input[0] & 0xfe) == 0xfe) {
-        // This is not a valid UTF-8 stream.
-        return INVALID;
-    }
-    else {
-        int sequence_length;
-        for (sequence_length = 1; input[0] & (0x80 >> sequence_length); ++sequence_length);
-        result = input[0] & ((1 << sequence_length) - 1);
-        // printf("squence length = %d ", sequence_length);
-        int index;
-        for(index = 1; index < sequence_length; ++index) {
-            input[index] = fgetc(f);
-            // printf("(i[%d] = %d) ", index, input[index]);
-            if (input[index] == EOF) {
-                return WEOF;
-            }
-            result = (result << 6) | (input[index] & 0x30);
-        }
-    }
-    return result;
-};
-
-#else
+// Decodes UTF-8 bytes into wc, returns amount of decoded chars.
+// wc must fit size + 1 chars.
+static int utf8ToWChar(const unsigned char *s, int size, wchar_t *wc) {
+	int i = 0;
+	int n = 0;
+	
+	// Skip BOM
+	if (size >= 3 && s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF)
+		i = 3;
+	
+	while (i < size) {
+		// ASCII fast path, 16 bytes at once
+		while (i + 16 <= size) {
+			unsigned char high = 0;
+			for (int j = 0; j < 16; ++j)
+				high |= s[i + j];
+			if (high & 0x80)
+				break;
+			
+			for (int j = 0; j < 16; ++j)
+				wc[n + j] = s[i + j];
+			i += 16;
+			n += 16;
+		}
+		
+		if (i >= size)
+			break;
+		
+		unsigned int c = s[i];
+		
+		if (c < 0x80) {
+			wc[n++] = c;
+			++i;
+			continue;
+		}
+		
+		// Length & minimal value of the sequence
+		int length;
+		unsigned int min;
+		if ((c & 0xE0) == 0xC0) {
+			length = 2;
+			min    = 0x80;
+			c     &= 0x1F;
+		} else if ((c & 0xF0) == 0xE0) {
+			length = 3;
+			min    = 0x800;
+			c     &= 0x0F;
+		} else if ((c & 0xF8) == 0xF0) {
+			length = 4;
+			min    = 0x10000;
+			c     &= 0x07;
+		} else {
+			wc[n++] = UTF8_REPLACEMENT;
+			++i;
+			continue;
+		}
+		
+		int j = 1;
+		for (; j < length && i + j < size && (s[i + j] & 0xC0) == 0x80; ++j)
+			c = (c << 6) | (s[i + j] & 0x3F);
+		
+		// Truncated, overlong, surrogate or out of range
+		if (j != length || c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+			wc[n++] = UTF8_REPLACEMENT;
+			++i;
+			continue;
+		}
+		
+		wc[n++] = c;
+		i += length;
+	}
 	
-static int fgetutf8c(FILE* f) {
-    return fgetwc(f);
+	wc[n] = 0;
+	return n;
 };
 
+// Reads & decodes whole file, returns text of length *length
+static wchar_t *readWholeFile(FILE *file, int *length) {
+	wchar_t *text = NULL;
+	
+#ifndef _WIN32
+	// Map regular file
+	struct stat st;
+	if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && st.st_size < 0x7FFFFFFF) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+		if (map != MAP_FAILED) {
+			text    = (wchar_t*) malloc((st.st_size + 1) * sizeof(wchar_t));
+			*length = utf8ToWChar((const unsigned char*) map, st.st_size, text);
+			munmap(map, st.st_size);
+			return text;
+		}
+	}
 #endif
+	
+	// Pipes, empty files & so on
+	int size     = 0;
+	int capacity = 4096;
+	unsigned char *bytes = (unsigned char*) malloc(capacity);
+	
+	int r;
+	while ((r = fread(bytes + size, 1, capacity - size, file)) > 0) {
+		size += r;
+		if (size == capacity) {
+			capacity *= 2;
+			bytes     = (unsigned char*) realloc(bytes, capacity);
+		}
+	}
+	
+	text    = (wchar_t*) malloc((size + 1) * sizeof(wchar_t));
+	*length = utf8ToWChar(bytes, size, text);
+	free(bytes);
+	return text;
+};
 
 struct FAKESTREAM {
 	FAKESTREAM_TYPE type;
@@ -116,73 +179,68 @@ struct FAKESTREAM {
 	wchar_t       *string;
 	FILE            *file;
 	
+	// Amount of chars in string
+	int length;
 	int cursor;
 	bool eof_;
 	
+	// Reads single line
 	FAKESTREAM() {
 		eof_ = 0;
-		this->type = IN_STDIN;
+		this->type   = IN_STDIN;
+		this->file   = NULL;
+		this->cursor = 0;
+		this->length = 0;
+		
+		int capacity = 256;
+		this->string = (wchar_t*) malloc(capacity * sizeof(wchar_t));
+		
+		int c;
+		while ((c = getwchar()) != WEOF && c != '\n') {
+			if (length + 1 == capacity) {
+				capacity *= 2;
+				string    = (wchar_t*) realloc(string, capacity * sizeof(wchar_t));
+			}
+			string[length++] = c;
+		}
+		string[length] = 0;
 	};
 	
 	FAKESTREAM(FILE *file) {
 		eof_ = 0;
-		this->type = IN_FILE;
-		this->file = file;
-#ifdef _WIN32
-		//_setmode(_fileno(file),  _O_U16TEXT);
-#endif
+		this->type   = IN_FILE;
+		this->file   = file;
+		this->cursor = 0;
+		this->string = readWholeFile(file, &length);
 	};
 	
 	FAKESTREAM(const char *string) {
 		eof_ = 0;
 		this->type   = IN_STRING;
+		this->file   = NULL;
 		this->string = charToWChar(string);
+		this->length = wcslen(this->string);
 		this->cursor = 0;
 	};
 	
 	~FAKESTREAM() {
-		switch (type) {
-			case IN_STRING:
-				free(string);
-				break;
-				
-			case IN_FILE:
-				fclose(file);
-				break;
-		};
+		free(string);
+		
+		if (type == IN_FILE)
+			fclose(file);
 	};
 	
 	int getc() {
 		if (eof_)
 			return WEOF;
 		
-		switch(type) {
-			case IN_STRING: {
-				int c = string[cursor];
-				if (!c) {
-					eof_ = 1;
-					return WEOF;
-				}
-				++cursor;
-				return c;
-			}
-			
-			case IN_FILE: {
-				int c = fgetwc(file);
-				eof_  = c == WEOF;
-				return c;
-			}
-			
-			case IN_STDIN: {
-				int c = getwchar();
-				if (c == WEOF || c == '\n') {
-					eof_ = 1;
-					return WEOF;
-				}
-				return c;
-			}
-		};
+		if (cursor >= length) {
+			eof_ = 1;
+			return WEOF;
+		}
+		
+		return string[cursor++];
 	};
 };
 
-#endif
\ No newline at end of file
+#endif
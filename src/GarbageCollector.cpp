@@ -18,16 +18,27 @@
 
 
 #include <sys/time.h>
+#include <time.h>
+#include <string.h>
 
 #include "GarbageCollector.h"
+#include "Tracer.h"
+#include "AllocProfiler.h"
 #include "objects/VirtualObject.h"
 
-#if defined GC_DEBUG || defined GC_FULL_DEBUG
-#include <stdio.h>
-#endif
+// Monotonic time in nanoseconds
+static inline unsigned long long gc_now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+};
 
 GarbageCollector GC;
 
+// Memory of the object being constructed, see GC_Object::operator new
+static void        *gc_new_ptr  = NULL;
+static unsigned int gc_new_size = 0;
+
 // GC_Chain
 GC_Chain::GC_Chain() {
 	next        = NULL;
@@ -45,10 +56,18 @@ GC_Object::GC_Object() {
 	gc_chain      = NULL;
 	gc_root_chain = NULL;
 	gc_lock_chain = NULL;
+	gc_site       = NULL;
+	gc_bytes      = this == gc_new_ptr ? gc_new_size : 0;
+	gc_new_ptr    = NULL;
 	GC.gc_attach(this);
+	
+	if (_alloc_profiler_enabled)
+		alloc_profiler_attach(this);
 };
 
 GC_Object::~GC_Object() {
+	if (gc_site)
+		alloc_profiler_free(this);
 	if (gc_chain)
 		gc_chain->deleted_ptr = 1;
 	if (gc_root_chain)
@@ -65,6 +84,22 @@ void GC_Object::mark() {
 // Called when GC destroyes current object
 void GC_Object::finalize() {};
 
+void GC_Object::references(GC_Visitor *visitor) {};
+
+void *GC_Object::operator new(size_t size) {
+	return gc_allocated(::operator new(size), size);
+};
+
+void GC_Object::operator delete(void *ptr) {
+	::operator delete(ptr);
+};
+
+void *GC_Object::gc_allocated(void *ptr, size_t size) {
+	gc_new_ptr  = ptr;
+	gc_new_size = size;
+	return ptr;
+};
+
 // GarbageCollector
 GarbageCollector::GarbageCollector() {
 	gc_size       = 0;
@@ -73,6 +108,7 @@ GarbageCollector::GarbageCollector() {
 	gc_locks      = NULL;
 	gc_objects    = NULL;
 	gc_collecting = 0;
+	memset(&gc_stats, 0, sizeof(gc_stats));
 };
 
 GarbageCollector::~GarbageCollector() {
@@ -209,6 +245,12 @@ void GarbageCollector::gc_collect(void) {
 		return;
 	
 	gc_collecting = 1;
+	
+	// Pause & amount of scanned / freed objects
+	unsigned long long start = gc_now();
+	int scanned              = gc_size;
+	int freed                = 0;
+	unsigned long long bytes = 0;
 
 #if defined GC_DEBUG || defined GC_FULL_DEBUG
 	struct timeval tp;
@@ -256,6 +298,7 @@ void GarbageCollector::gc_collect(void) {
 			delete tmp;
 		} else {
 			chain->object->mark();
+			++gc_stats.roots_scanned;
 			GC_Chain *tmp = chain;
 			chain         = chain->next;
 			
@@ -287,6 +330,7 @@ void GarbageCollector::gc_collect(void) {
 #endif
 
 			chain->object->mark();
+			++gc_stats.locks_scanned;
 			GC_Chain *tmp = chain;
 			chain         = chain->next;
 			
@@ -328,11 +372,17 @@ void GarbageCollector::gc_collect(void) {
 			// tmp->object->test();
 			tmp->object->finalize();
 
+			++freed;
+			bytes += tmp->object->gc_bytes;
+			if (tmp->object->gc_site)
+				alloc_profiler_free(tmp->object);
 			delete tmp->object;
 			delete tmp;			
 		} else {
 			// Reset
 			chain->object->gc_reachable = 0;
+			if (chain->object->gc_site)
+				alloc_profiler_survived(chain->object);
 			GC_Chain *tmp = chain;
 			chain         = chain->next;
 			
@@ -350,9 +400,52 @@ void GarbageCollector::gc_collect(void) {
 	printf("GC_collect %d object(s) (%d dead) (%d locked) from total %d object(s) for %ld ms\n", deleted_amount, dead_amount, lock_amount, total_amount, ms_end - ms_start);
 #endif
 
+	if (_alloc_profiler_enabled)
+		alloc_profiler_cycle();
+	
+	unsigned long long pause = gc_now() - start;
+	
+	++gc_stats.cycles;
+	gc_stats.pause_total_ns += pause;
+	gc_stats.objects_freed  += freed;
+	gc_stats.bytes_freed    += bytes;
+	if (pause > gc_stats.pause_max_ns)
+		gc_stats.pause_max_ns = pause;
+	
+	int bucket = 0;
+	for (unsigned long long us = pause / 1000; us && bucket < GC_PAUSE_BUCKETS - 1; us >>= 1)
+		++bucket;
+	++gc_stats.pauses[bucket];
+	
+	if (_tracer_enabled)
+		tracer_complete(TRACER_GC, "GC.collect", start, "scanned", scanned, "freed", freed);
+
 	gc_collecting = 0;	
 };
 
+void GarbageCollector::gc_write_stats(FILE *out) {
+	fprintf(out, "{\n");
+	fprintf(out, "\t\"cycles\": %llu,\n",         gc_stats.cycles);
+	fprintf(out, "\t\"pause_total_ns\": %llu,\n", gc_stats.pause_total_ns);
+	fprintf(out, "\t\"pause_max_ns\": %llu,\n",   gc_stats.pause_max_ns);
+	fprintf(out, "\t\"pause_mean_ns\": %llu,\n",  gc_stats.cycles ? gc_stats.pause_total_ns / gc_stats.cycles : 0);
+	fprintf(out, "\t\"objects_freed\": %llu,\n",  gc_stats.objects_freed);
+	fprintf(out, "\t\"bytes_freed\": %llu,\n",    gc_stats.bytes_freed);
+	fprintf(out, "\t\"roots_scanned\": %llu,\n",  gc_stats.roots_scanned);
+	fprintf(out, "\t\"locks_scanned\": %llu,\n",  gc_stats.locks_scanned);
+	fprintf(out, "\t\"objects\": %d,\n",          gc_size);
+	fprintf(out, "\t\"roots\": %d,\n",            gc_roots_size);
+	
+	// Histogram as exclusive upper bound in us -> count, last bucket is unbounded
+	fprintf(out, "\t\"pause_histogram_us\": [");
+	for (int i = 0; i < GC_PAUSE_BUCKETS; ++i)
+		if (i == GC_PAUSE_BUCKETS - 1)
+			fprintf(out, "\n\t\t{\"lt\": null, \"count\": %llu}", gc_stats.pauses[i]);
+		else
+			fprintf(out, "\n\t\t{\"lt\": %llu, \"count\": %llu},", 1ull << i, gc_stats.pauses[i]);
+	fprintf(out, "\n\t]\n}\n");
+};
+
 void GarbageCollector::gc_dispose(void) {	
 	if (gc_collecting)
 		return;
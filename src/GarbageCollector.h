@@ -24,11 +24,19 @@
 #define GARBAGE_COLLECTOR_H
 
 #include <stdlib.h>
+#include <stdio.h>
 
 // #define GC_DEBUG
 // #define GC_FULL_DEBUG
 
 struct GC_Object;
+struct AllocSite;
+
+// Receives references of the object, see GC_Object::references.
+// Passed object may be NULL.
+struct GC_Visitor {
+	virtual void visit(GC_Object *o) = 0;
+};
 
 struct GC_Chain {
 	GC_Object     *object;
@@ -47,6 +55,10 @@ struct GC_Object {
 	GC_Chain *gc_chain;
 	GC_Chain *gc_lock_chain;
 	GC_Chain *gc_root_chain;
+	// Size of the object allocated with new, 0 for objects on stack
+	unsigned int  gc_bytes;
+	// Allocation site, set by allocation profiler
+	AllocSite    *gc_site;
 	
 	GC_Object();
 	
@@ -57,6 +69,34 @@ struct GC_Object {
 	
 	// Called when GC destroyes current object
 	virtual void finalize();
+	
+	// Passes all objects, marked by mark() of this object, to the visitor.
+	// Used for building heap snapshots, does not change reachability.
+	virtual void references(GC_Visitor *visitor);
+	
+	static void *operator new(size_t);
+	static void operator delete(void*);
+	
+	// Remembers size of memory allocated for the next constructed object.
+	// Used by overloaded operator new of derived types.
+	static void *gc_allocated(void *ptr, size_t size);
+};
+
+// Amount of pause histogram buckets. 
+// Bucket 0 counts pauses under 1 us, bucket i - pauses in [2^(i-1), 2^i) us,
+// the last one counts all longer pauses.
+#define GC_PAUSE_BUCKETS 24
+
+// Always-on telemetry of gc_collect
+struct GC_Stats {
+	unsigned long long cycles;
+	unsigned long long pause_total_ns;
+	unsigned long long pause_max_ns;
+	unsigned long long objects_freed;
+	unsigned long long bytes_freed;
+	unsigned long long roots_scanned;
+	unsigned long long locks_scanned;
+	unsigned long long pauses[GC_PAUSE_BUCKETS];
 };
 
 // Автаматик обжэкт флов контрол
@@ -69,6 +109,7 @@ struct GarbageCollector {
 	GC_Chain   *gc_roots;
 	GC_Chain   *gc_locks;
 	GC_Chain *gc_objects;
+	GC_Stats    gc_stats;
 	
 	GarbageCollector();
 	
@@ -90,6 +131,9 @@ struct GarbageCollector {
 	void gc_collect(void);
 	
 	void gc_dispose(void);
+	
+	// Writes gc_stats as JSON object
+	void gc_write_stats(FILE *out);
 };
 
 // Global instance of the GarbageCollector
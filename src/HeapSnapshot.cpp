@@ -0,0 +1,223 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "HeapSnapshot.h"
+#include "GarbageCollector.h"
+#include "Context.h"
+
+#include "objects/VirtualObject.h"
+#include "objects/Object.h"
+#include "objects/Double.h"
+
+const char *tokenToString(int token);
+
+// GC_Object -> node index, open addressing
+struct HeapIndex {
+	GC_Object **keys;
+	int        *values;
+	int           size;
+};
+
+static unsigned int pointerHash(GC_Object *o) {
+	unsigned long h = (unsigned long) o;
+	h ^= h >> 17;
+	h *= 0x9E3779B1u;
+	return (unsigned int) (h ^ (h >> 13));
+};
+
+static void indexPut(HeapIndex *index, GC_Object *o, int value) {
+	unsigned int i = pointerHash(o) & (index->size - 1);
+	while (index->keys[i])
+		i = (i + 1) & (index->size - 1);
+	index->keys[i]   = o;
+	index->values[i] = value;
+};
+
+static int indexGet(HeapIndex *index, GC_Object *o) {
+	unsigned int i = pointerHash(o) & (index->size - 1);
+	while (index->keys[i]) {
+		if (index->keys[i] == o)
+			return index->values[i];
+		i = (i + 1) & (index->size - 1);
+	}
+	return -1;
+};
+
+static int objectType(GC_Object *o) {
+	VirtualObject *v = dynamic_cast<VirtualObject*>(o);
+	if (v)
+		return v->type;
+	if (dynamic_cast<Context*>(o))
+		return HEAP_SNAPSHOT_CONTEXT;
+	return HEAP_SNAPSHOT_OTHER;
+};
+
+static const char *typeName(int type, char *buffer, int size) {
+	if (type == HEAP_SNAPSHOT_CONTEXT)
+		return "Context";
+	if (type == HEAP_SNAPSHOT_OTHER)
+		return "<other>";
+	
+	return typeToString(type, buffer, size);
+};
+
+static void writeInt(FILE *out, unsigned int v) {
+	for (int i = 0; i < 4; ++i)
+		fputc((v >> (8 * i)) & 0xFF, out);
+};
+
+static void writeLong(FILE *out, unsigned long long v) {
+	for (int i = 0; i < 8; ++i)
+		fputc((v >> (8 * i)) & 0xFF, out);
+};
+
+// Collects references of single object
+struct HeapEdges : GC_Visitor {
+	HeapIndex *index;
+	int       *edges;
+	int        count;
+	int         size;
+	
+	void visit(GC_Object *o) {
+		if (!o)
+			return;
+		
+		int i = indexGet(index, o);
+		if (i < 0)
+			return;
+		
+		if (count == size) {
+			size  = size ? size * 2 : 16;
+			edges = (int*) realloc(edges, size * sizeof(int));
+		}
+		edges[count++] = i;
+	};
+};
+
+bool heap_snapshot(const char *path) {
+	FILE *out = fopen(path, "wb");
+	if (!out)
+		return 0;
+	
+	int count = 0;
+	for (GC_Chain *c = GC.gc_objects; c; c = c->next)
+		if (!c->deleted_ptr)
+			++count;
+	
+	HeapIndex index;
+	index.size = 16;
+	while (index.size < count * 2)
+		index.size <<= 1;
+	index.keys   = (GC_Object**) calloc(index.size, sizeof(GC_Object*));
+	index.values = (int*)        malloc(index.size * sizeof(int));
+	
+	GC_Object **nodes = (GC_Object**) malloc((count + 1) * sizeof(GC_Object*));
+	int        *types = (int*)        malloc((count + 1) * sizeof(int));
+	count = 0;
+	for (GC_Chain *c = GC.gc_objects; c; c = c->next)
+		if (!c->deleted_ptr) {
+			indexPut(&index, c->object, count);
+			types[count]   = objectType(c->object);
+			nodes[count++] = c->object;
+		}
+	
+	writeInt(out, HEAP_SNAPSHOT_MAGIC);
+	writeInt(out, HEAP_SNAPSHOT_VERSION);
+	
+	// Names of types present in snapshot
+	char present[256 + 2] = { 0 };
+	int ntypes = 0;
+	for (int i = 0; i < count; ++i)
+		if (types[i] >= HEAP_SNAPSHOT_CONTEXT && types[i] < 256 && !present[types[i] + 2]) {
+			present[types[i] + 2] = 1;
+			++ntypes;
+		}
+	
+	char buffer[32];
+	writeInt(out, ntypes);
+	for (int t = HEAP_SNAPSHOT_CONTEXT; t < 256; ++t)
+		if (present[t + 2]) {
+			const char *name = typeName(t, buffer, sizeof(buffer));
+			int length = 0;
+			while (name[length])
+				++length;
+			
+			writeInt(out, t);
+			writeInt(out, length);
+			fwrite(name, 1, length, out);
+		}
+	
+	HeapEdges edges;
+	edges.index = &index;
+	edges.edges = NULL;
+	edges.size  = 0;
+	
+	writeInt(out, count);
+	for (int i = 0; i < count; ++i) {
+		GC_Object *o = nodes[i];
+		
+		edges.count = 0;
+		o->references(&edges);
+		
+		writeLong(out, (unsigned long) o);
+		writeInt(out, types[i]);
+		writeInt(out, o->gc_bytes);
+		writeInt(out, (o->gc_root ? HEAP_SNAPSHOT_ROOT : 0) | (o->gc_lock ? HEAP_SNAPSHOT_LOCK : 0));
+		writeInt(out, edges.count);
+		for (int j = 0; j < edges.count; ++j)
+			writeInt(out, edges.edges[j]);
+	}
+	
+	free(edges.edges);
+	free(index.keys);
+	free(index.values);
+	free(nodes);
+	free(types);
+	
+	return !fclose(out);
+};
+
+VirtualObject *heap_census() {
+	// Type + 2, see HEAP_SNAPSHOT_CONTEXT
+	long long count[256 + 2] = { 0 };
+	long long bytes[256 + 2] = { 0 };
+	
+	for (GC_Chain *c = GC.gc_objects; c; c = c->next)
+		if (!c->deleted_ptr) {
+			int t = objectType(c->object);
+			if (t < HEAP_SNAPSHOT_CONTEXT || t >= 256)
+				t = HEAP_SNAPSHOT_OTHER;
+			++count[t + 2];
+			bytes[t + 2] += c->object->gc_bytes;
+		}
+	
+	char buffer[32];
+	Object *result = new Object;
+	for (int t = HEAP_SNAPSHOT_CONTEXT; t < 256; ++t)
+		if (count[t + 2]) {
+			Object *o = new Object;
+			o->table->put(string("count"), new Double(count[t + 2]));
+			o->table->put(string("bytes"), new Double(bytes[t + 2]));
+			result->table->put(string(typeName(t, buffer, sizeof(buffer))), o);
+		}
+	
+	return result;
+};
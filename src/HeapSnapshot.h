@@ -0,0 +1,52 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Heap snapshot & census (GC.snapshot(path), GC.census()).
+ * Snapshot is a binary graph of all objects attached to GC,
+ * edges are collected by GC_Object::references.
+ * Two snapshots are compared offline by tools/heapdiff.
+ * 
+ * File layout, integers are 32 bit & addresses 64 bit little endian:
+ *   magic, version
+ *   types count, { type, name length, name }
+ *   nodes count, { address, type, bytes, flags, edges count, { node index } }
+ */
+
+#ifndef HEAP_SNAPSHOT_H
+#define HEAP_SNAPSHOT_H
+
+#define HEAP_SNAPSHOT_MAGIC   0x53484B43
+#define HEAP_SNAPSHOT_VERSION 1
+
+// Node flags
+#define HEAP_SNAPSHOT_ROOT    1
+#define HEAP_SNAPSHOT_LOCK    2
+
+// Types of objects that are not VirtualObject
+#define HEAP_SNAPSHOT_OTHER   -1
+#define HEAP_SNAPSHOT_CONTEXT -2
+
+struct VirtualObject;
+
+// Writes snapshot of all objects into the file, returns 0 on failure
+bool heap_snapshot(const char *path);
+
+// Returns object { type name: { count, bytes } } for all objects
+VirtualObject *heap_census();
+
+#endif
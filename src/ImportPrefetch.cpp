@@ -0,0 +1,349 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "TokenNamespace.h"
+#include "ImportPrefetch.h"
+#include "TokenStream.h"
+#include "Parser.h"
+#include "ASTOptimizer.h"
+#include "ASTCache.h"
+
+int _import_prefetch_threads = 0;
+
+enum ImportJobState {
+	IJ_QUEUED,
+	IJ_PARSING,
+	IJ_DONE,
+	// Taken by Runtime.importFile
+	IJ_TAKEN
+};
+
+struct ImportJob {
+	ImportJob         *next;
+	// Real path of the file
+	char              *path;
+	// Directory of the file, base of it's imports
+	char               *dir;
+	unsigned long long mtime;
+	long long           size;
+	int                state;
+	// Parsed tree / NULL on error
+	ASTNode            *tree;
+};
+
+static pthread_mutex_t import_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  import_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t       import_threads[IMPORT_PREFETCH_MAX_THREADS];
+static int             import_thread_count = 0;
+// Jobs in order of queueing
+static ImportJob      *import_jobs         = NULL;
+static ImportJob      *import_jobs_tail    = NULL;
+// Amount of jobs being parsed
+static int             import_active       = 0;
+static bool            import_stopping     = 0;
+
+int import_prefetch_default_threads() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+		return 1;
+	return n > IMPORT_PREFETCH_MAX_THREADS ? IMPORT_PREFETCH_MAX_THREADS : (int) n;
+};
+
+static bool fileState(const char *path, unsigned long long *mtime, long long *size) {
+	struct stat st;
+	if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+		return 0;
+	
+	*mtime = st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+	*size  = st.st_size;
+	return 1;
+};
+
+// Encodes name into UTF-8. 
+// string::toCString is not used, it changes locale.
+static char *utf8(string *name) {
+	char *s = (char*) malloc(4 * name->length + 1);
+	int   n = 0;
+	
+	for (int i = 0; i < name->length; ++i) {
+		unsigned int c = name->buffer[i];
+		
+		if (c < 0x80)
+			s[n++] = c;
+		else if (c < 0x800) {
+			s[n++] = 0xC0 | (c >> 6);
+			s[n++] = 0x80 | (c & 0x3F);
+		} else if (c < 0x10000) {
+			s[n++] = 0xE0 | (c >> 12);
+			s[n++] = 0x80 | ((c >> 6) & 0x3F);
+			s[n++] = 0x80 | (c & 0x3F);
+		} else {
+			s[n++] = 0xF0 | (c >> 18);
+			s[n++] = 0x80 | ((c >> 12) & 0x3F);
+			s[n++] = 0x80 | ((c >> 6) & 0x3F);
+			s[n++] = 0x80 | (c & 0x3F);
+		}
+	}
+	
+	s[n] = 0;
+	return s;
+};
+
+// Resolves path as Runtime.importFile does: 
+// relative to working directory, then to script directory.
+// Returns malloc'ed real path / NULL.
+static char *resolve(string *name, const char *dir) {
+	char *file = utf8(name);
+	
+	struct stat st;
+	char *real = NULL;
+	
+	if (stat(file, &st) == 0)
+		real = realpath(file, NULL);
+	else if (dir && file[0] != '/') {
+		int length   = strlen(dir) + strlen(file) + 2;
+		char *joined = (char*) malloc(length);
+		snprintf(joined, length, "%s/%s", dir, file);
+		real = realpath(joined, NULL);
+		free(joined);
+	}
+	
+	free(file);
+	return real;
+};
+
+// Queues file if it is not queued yet, takes ownership of path
+static void enqueue(char *path) {
+	unsigned long long mtime;
+	long long           size;
+	if (!fileState(path, &mtime, &size)) {
+		free(path);
+		return;
+	}
+	
+	pthread_mutex_lock(&import_lock);
+	
+	for (ImportJob *j = import_jobs; j; j = j->next)
+		if (!strcmp(j->path, path)) {
+			pthread_mutex_unlock(&import_lock);
+			free(path);
+			return;
+		}
+	
+	ImportJob *job = new ImportJob;
+	job->next      = NULL;
+	job->path      = path;
+	job->mtime     = mtime;
+	job->size      = size;
+	job->state     = IJ_QUEUED;
+	job->tree      = NULL;
+	
+	// Imports of the file are resolved relative to it's directory
+	job->dir = strdup(path);
+	char *slash = strrchr(job->dir, '/');
+	if (slash)
+		slash[slash == job->dir ? 1 : 0] = 0;
+	
+	if (import_jobs_tail)
+		import_jobs_tail->next = job;
+	else
+		import_jobs = job;
+	import_jobs_tail = job;
+	
+	pthread_cond_signal(&import_cond);
+	pthread_mutex_unlock(&import_lock);
+};
+
+// Returns 1 if node is Runtime.importFile / Runtime.importOnce
+static bool isImportFunction(ASTNode *node) {
+	if (node->type != FIELD || !node->objectlist || !node->left)
+		return 0;
+	
+	string *field    = (string*) node->objectlist->object;
+	ASTNode *runtime = node->left;
+	
+	if (runtime->type != NAME || !runtime->objectlist || !(*(string*) runtime->objectlist->object == L"Runtime"))
+		return 0;
+	
+	return *field == L"importFile" || *field == L"importOnce";
+};
+
+// Queues imports with literal path found in the tree
+static void scan(ASTNode *node, const char *dir) {
+	for (; node; node = node->next) {
+		if (node->type == CALL && node->left && isImportFunction(node->left)) {
+			ASTNode *arg = node->left->next;
+			
+			if (arg && arg->type == STRING && arg->objectlist) {
+				char *path = resolve((string*) arg->objectlist->object, dir);
+				if (path)
+					enqueue(path);
+			}
+		}
+		
+		scan(node->left, dir);
+	}
+};
+
+// Parses file, returns tree / NULL, errors are reported by the importer
+static ASTNode *parse(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return NULL;
+	
+	FAKESTREAM  fs(f);
+	ASTNode *tree = ast_cache_load(path, fs.string, fs.length);
+	
+	if (!tree) {
+		TokenStream ts;
+		Parser       p;
+		ts.silent_ = 1;
+		p.silent_  = 1;
+		ts.init(&fs);
+		p.init(&ts);
+		
+		tree = p.parse();
+		if (!tree)
+			return NULL;
+		
+		optimizeAST(tree);
+		ast_cache_store(path, fs.string, fs.length, tree);
+	}
+	
+	return tree;
+};
+
+static void *worker(void *arg) {
+	pthread_mutex_lock(&import_lock);
+	
+	while (!import_stopping) {
+		ImportJob *job = import_jobs;
+		while (job && job->state != IJ_QUEUED)
+			job = job->next;
+		
+		if (!job) {
+			// Parsed files may queue more
+			if (!import_active)
+				break;
+			
+			pthread_cond_wait(&import_cond, &import_lock);
+			continue;
+		}
+		
+		job->state = IJ_PARSING;
+		++import_active;
+		pthread_mutex_unlock(&import_lock);
+		
+		ASTNode *tree = parse(job->path);
+		if (tree)
+			scan(tree->left, job->dir);
+		
+		pthread_mutex_lock(&import_lock);
+		job->tree  = tree;
+		job->state = IJ_DONE;
+		--import_active;
+		pthread_cond_broadcast(&import_cond);
+	}
+	
+	pthread_mutex_unlock(&import_lock);
+	return NULL;
+};
+
+void import_prefetch_start(ASTNode *root, const char *script_dir) {
+	if (_import_prefetch_threads <= 0 || !root)
+		return;
+	
+	scan(root->left, script_dir);
+	
+	if (!import_jobs)
+		return;
+	
+	int count = _import_prefetch_threads > IMPORT_PREFETCH_MAX_THREADS ? IMPORT_PREFETCH_MAX_THREADS : _import_prefetch_threads;
+	
+	import_stopping = 0;
+	for (int i = 0; i < count; ++i)
+		if (pthread_create(&import_threads[import_thread_count], NULL, worker, NULL) == 0)
+			++import_thread_count;
+};
+
+ASTNode *import_prefetch_take(const char *path, unsigned long long mtime, long long size) {
+	if (!import_jobs)
+		return NULL;
+	
+	pthread_mutex_lock(&import_lock);
+	
+	ImportJob *job = import_jobs;
+	while (job && strcmp(job->path, path))
+		job = job->next;
+	
+	if (!job || job->state == IJ_TAKEN) {
+		pthread_mutex_unlock(&import_lock);
+		return NULL;
+	}
+	
+	// Parsing by caller is faster than waiting for the queue
+	if (job->state == IJ_QUEUED) {
+		job->state = IJ_TAKEN;
+		pthread_mutex_unlock(&import_lock);
+		return NULL;
+	}
+	
+	while (job->state == IJ_PARSING)
+		pthread_cond_wait(&import_cond, &import_lock);
+	
+	ASTNode *tree = job->tree;
+	job->tree     = NULL;
+	job->state    = IJ_TAKEN;
+	pthread_mutex_unlock(&import_lock);
+	
+	if (tree && (job->mtime != mtime || job->size != size)) {
+		delete tree;
+		return NULL;
+	}
+	
+	return tree;
+};
+
+void import_prefetch_stop() {
+	pthread_mutex_lock(&import_lock);
+	import_stopping = 1;
+	pthread_cond_broadcast(&import_cond);
+	pthread_mutex_unlock(&import_lock);
+	
+	for (int i = 0; i < import_thread_count; ++i)
+		pthread_join(import_threads[i], NULL);
+	import_thread_count = 0;
+	
+	while (import_jobs) {
+		ImportJob *next = import_jobs->next;
+		delete import_jobs->tree;
+		free(import_jobs->path);
+		free(import_jobs->dir);
+		delete import_jobs;
+		import_jobs = next;
+	}
+	import_jobs_tail = NULL;
+	import_active    = 0;
+};
@@ -0,0 +1,55 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Background parsing of imported files (ck --prefetch-imports).
+ * Before execution the tree of the script is scanned for 
+ * Runtime.importFile / Runtime.importOnce calls with literal path, 
+ * found files are parsed on a pool of threads with own TokenStream & 
+ * Parser each, files imported by them are queued the same way.
+ * Runtime.importFile takes finished tree instead of parsing the file, 
+ * files that are not parsed yet are parsed by the caller.
+ */
+
+#ifndef IMPORT_PREFETCH_H
+#define IMPORT_PREFETCH_H
+
+// Max amount of parser threads
+#define IMPORT_PREFETCH_MAX_THREADS 16
+
+struct ASTNode;
+
+// Amount of parser threads, 0 if prefetch is disabled
+extern int _import_prefetch_threads;
+
+// Returns default amount of parser threads (online CPUs)
+int import_prefetch_default_threads();
+
+// Queues files imported by the tree with literal paths and starts 
+// parser threads. Relative paths are resolved as by Runtime.importFile.
+void import_prefetch_start(ASTNode *root, const char *script_dir);
+
+// Returns tree of prefetched file with given real path & state, 
+// waits if file is being parsed. Returns NULL if file was not queued,
+// is not parsed yet, failed to parse or changed since.
+// Tree is owned by caller.
+ASTNode *import_prefetch_take(const char *path, unsigned long long mtime, long long size);
+
+// Stops parser threads, disposes trees that were not taken
+void import_prefetch_stop();
+
+#endif
@@ -29,13 +29,21 @@ void Parser::init(TokenStream *source) {
 	this->eof_ = 0;
 	this->error_ = 0;
 	this->source = source;
+	
+	delete this->arena;
+	this->arena = new Arena(AST_ARENA_CHUNK_SIZE);
+	
 	next(); next(); next(); next();
 };
 
+// Tokens are owned by TokenStream, 
+// arena is owned by the parsed tree after successful parse()
 Parser::~Parser() {
-	for (int i = 0; i < 7; i++)
-		delete this->buffer[i];
-	// delete buffer;
+	delete arena;
+};
+
+string *Parser::tokenString() {
+	return astString(arena, get(-1)->text, get(-1)->length);
 };
 
 RawToken *Parser::get(int off) {
@@ -45,14 +53,12 @@ RawToken *Parser::get(int off) {
 };
 
 RawToken *Parser::next() {
-	if (this->buffer[0] != NULL)
-		delete this->buffer[0];
 	for (int i = 1; i < 7; i++)
 		this->buffer[i - 1] = this->buffer[i];
 	this->source->nextToken();
 	if (this->source->token->token == TERR)
 		noline_parser_error("TS Error");
-	this->buffer[6] = this->source->token->copy();
+	this->buffer[6] = this->source->token;
 	
 	if (buffer[3] != NULL && buffer[3]->token == TEOF)
 		eof_ = 1;
@@ -72,18 +78,22 @@ bool Parser::match(int token) {
 };
 
 ASTNode *Parser::noline_parser_error(const char *msg) {
-	chighred;
-	printf("Parser error : %s\n", msg);
-	cwhite;
+	if (!silent_) {
+		chighred;
+		printf("Parser error : %s\n", msg);
+		cwhite;
+	}
 	
 	error_ = true;
 	return NULL;
 };
 
 ASTNode *Parser::parser_error(const char *msg) {
-	chighred;
-	printf("Parser error at %d : %s\n", get(0)->lineno, msg);
-	creset;
+	if (!silent_) {
+		chighred;
+		printf("Parser error at %d : %s\n", get(0)->lineno, msg);
+		creset;
+	}
 	
 	error_ = true;
 	return NULL;
@@ -99,11 +109,9 @@ ASTNode *Parser::primaryexp() {
 		// value
 		
 		DEBUG("INTEGER expression")
-		ASTNode *integerexp = new ASTNode(get(-1)->lineno, INTEGER);
+		ASTNode *integerexp = new (arena) ASTNode(get(-1)->lineno, INTEGER);
 		
-		int *n = new int;
-		*n = get(-1)->integerv;
-		integerexp->addLastObject(n);
+		integerexp->addLastObject(astObject<int>(arena, get(-1)->integerv));
 		return integerexp;
 	}
 	
@@ -112,11 +120,9 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("LONG expression")
-		ASTNode *longexp = new ASTNode(get(-1)->lineno, LONG);
+		ASTNode *longexp = new (arena) ASTNode(get(-1)->lineno, LONG);
 		
-		long *n = new long;
-		*n = get(-1)->longv;
-		longexp->addLastObject(n);
+		longexp->addLastObject(astObject<long>(arena, get(-1)->longv));
 		
 		return longexp;
 	}
@@ -126,11 +132,9 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("BYTE expression")
-		ASTNode *byteexp = new ASTNode(get(-1)->lineno, BYTE);
+		ASTNode *byteexp = new (arena) ASTNode(get(-1)->lineno, BYTE);
 		
-		char *n = new char;
-		*n = get(-1)->bytev;
-		byteexp->addLastObject(n);
+		byteexp->addLastObject(astObject<char>(arena, get(-1)->bytev));
 		
 		return byteexp;
 	}
@@ -140,11 +144,9 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("BOOLEAN expression")
-		ASTNode *booleanexp = new ASTNode(get(-1)->lineno, BOOLEAN);
+		ASTNode *booleanexp = new (arena) ASTNode(get(-1)->lineno, BOOLEAN);
 		
-		bool *n = new bool;
-		*n = get(-1)->booleanv;
-		booleanexp->addLastObject(n);
+		booleanexp->addLastObject(astObject<bool>(arena, get(-1)->booleanv));
 		
 		return booleanexp;
 	}
@@ -154,11 +156,9 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("DOUBLE expression")
-		ASTNode *doubleexp = new ASTNode(get(-1)->lineno, DOUBLE);
+		ASTNode *doubleexp = new (arena) ASTNode(get(-1)->lineno, DOUBLE);
 		
-		double *n = new double;
-		*n = get(-1)->doublev;
-		doubleexp->addLastObject(n);
+		doubleexp->addLastObject(astObject<double>(arena, get(-1)->doublev));
 		
 		return doubleexp;
 	}
@@ -168,9 +168,9 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("NAME expression")
-		ASTNode *nameexp = new ASTNode(get(-1)->lineno, NAME);
+		ASTNode *nameexp = new (arena) ASTNode(get(-1)->lineno, NAME);
 		
-		nameexp->addLastObject(get(-1)->stringv->copy());
+		nameexp->addLastObject(tokenString());
 		
 		return nameexp;
 	}
@@ -180,37 +180,37 @@ ASTNode *Parser::primaryexp() {
 		// OBJECTS:
 		// value
 		DEBUG("STRING expression")
-		ASTNode *stringexp = new ASTNode(get(-1)->lineno, STRING);
+		ASTNode *stringexp = new (arena) ASTNode(get(-1)->lineno, STRING);
 		
-		stringexp->addLastObject(get(-1)->stringv->copy());
+		stringexp->addLastObject(tokenString());
 		
 		return stringexp;
 	}
 	
 	if (match(THIS)) {
 		DEBUG("THIS expression")
-		ASTNode *thisexp = new ASTNode(get(-1)->lineno, THIS);
+		ASTNode *thisexp = new (arena) ASTNode(get(-1)->lineno, THIS);
 		
 		return thisexp;
 	}
 	
 	if (match(SELF)) {
 		DEBUG("SELF expression")
-		ASTNode *selfexp = new ASTNode(get(-1)->lineno, SELF);
+		ASTNode *selfexp = new (arena) ASTNode(get(-1)->lineno, SELF);
 		
 		return selfexp;
 	}
 	
 	if (match(TNULL)) {
 		DEBUG("NULL expression")
-		ASTNode *nullexp = new ASTNode(get(-1)->lineno, TNULL);
+		ASTNode *nullexp = new (arena) ASTNode(get(-1)->lineno, TNULL);
 		
 		return nullexp;
 	}
 	
 	if (match(UNDEFINED)) {
 		DEBUG("NULL expression")
-		ASTNode *undefinedexp = new ASTNode(get(-1)->lineno, UNDEFINED);
+		ASTNode *undefinedexp = new (arena) ASTNode(get(-1)->lineno, UNDEFINED);
 		
 		return undefinedexp;
 	}
@@ -243,10 +243,9 @@ ASTNode *Parser::primaryexp() {
 		
 		DEBUG("ARRAY expression")
 		
-		ASTNode *array = new ASTNode(get(-1)->lineno, ARRAY);
-		int *length = new int;
+		ASTNode *array = new (arena) ASTNode(get(-1)->lineno, ARRAY);
+		int *length = astObject<int>(arena, 0);
 		array->addLastObject(length);
-		*length = 0;
 		
 		if (match(RB))
 			return array;
@@ -289,7 +288,7 @@ ASTNode *Parser::primaryexp() {
 		
 		DEBUG("OBJECT expression")
 		
-		ASTNode *object = new ASTNode(get(-1)->lineno, OBJECT);
+		ASTNode *object = new (arena) ASTNode(get(-1)->lineno, OBJECT);
 		
 		if (match(RC))
 			return object;
@@ -300,17 +299,15 @@ ASTNode *Parser::primaryexp() {
 				return parser_error("Expected name or string");
 			}
 			
-			string *name = get(-1)->stringv->copy();
+			string *name = tokenString();
 			
 			if (!match(COLON)) {
-				delete name;
 				delete object;
 				return parser_error("Expected :");
 			}
 			
 			ASTNode *elem = expression();
 			if (checkNullExpression(elem))  {
-				delete name;
 				delete object;
 				return NULL;
 			}
@@ -344,7 +341,7 @@ ASTNode *Parser::primaryexp() {
 		
 		DEBUG("FUNCTION node")
 		
-		ASTNode *function = new ASTNode(get(-1)->lineno, FUNCTION);
+		ASTNode *function = new (arena) ASTNode(get(-1)->lineno, FUNCTION);
 		
 		if (match(LP)) 
 			if (!match(RP))
@@ -354,7 +351,7 @@ ASTNode *Parser::primaryexp() {
 						return parser_error("Expected name");
 					}
 					
-					function->addLastObject(get(-1)->stringv->copy());
+					function->addLastObject(tokenString());
 					
 					if (match(TEOF)) {
 						delete function;
@@ -374,7 +371,8 @@ ASTNode *Parser::primaryexp() {
 		return function;
 	}
 	
-	printf("Parser error at %d : Unexpected token %d (%s)\n", get(0)->lineno, get(0)->token, tokenToString(get(0)->token));
+	if (!silent_)
+		printf("Parser error at %d : Unexpected token %d (%s)\n", get(0)->lineno, get(0)->token, tokenToString(get(0)->token));
 	error_ = true;
 	return NULL;
 };
@@ -416,7 +414,7 @@ ASTNode *Parser::member_expression() {
 					return NULL;
 				}
 				
-				ASTNode *node = new ASTNode(lineno, MEMBER);
+				ASTNode *node = new (arena) ASTNode(lineno, MEMBER);
 				node->addChild(exp);
 				node->addChild(ind);
 				exp = node;
@@ -435,7 +433,7 @@ ASTNode *Parser::member_expression() {
 				// OBJECTS:
 				// field_name
 				
-				ASTNode *node = new ASTNode(lineno, FIELD);
+				ASTNode *node = new (arena) ASTNode(lineno, FIELD);
 				node->addChild(exp);
 				exp = node;
 				
@@ -443,7 +441,7 @@ ASTNode *Parser::member_expression() {
 					delete exp;
 					return parser_error("Expected name");
 				}
-				node->addLastObject(get(-1)->stringv->copy());
+				node->addLastObject(tokenString());
 				
 				break;
 			}
@@ -455,7 +453,7 @@ ASTNode *Parser::member_expression() {
 				// ...
 				// argn
 				
-				ASTNode *node = new ASTNode(lineno, CALL);
+				ASTNode *node = new (arena) ASTNode(lineno, CALL);
 				node->addChild(exp);
 				exp = node;
 				
@@ -509,7 +507,7 @@ ASTNode *Parser::unary_expression() {
 		if (checkNullExpression(exp)) 
 			return NULL;
 		
-		ASTNode *expr = new ASTNode(lineno, token == PLUS ? POS : token == MINUS ? NEG : token);
+		ASTNode *expr = new (arena) ASTNode(lineno, token == PLUS ? POS : token == MINUS ? NEG : token);
 		expr->addChild(exp);
 		
 		return expr;						
@@ -529,7 +527,7 @@ ASTNode *Parser::unary_expression() {
 			||
 			exp->type == MEMBER) 
 		{
-			ASTNode *expr = new ASTNode(lineno, token == INC ? PRE_INC : PRE_DEC);
+			ASTNode *expr = new (arena) ASTNode(lineno, token == INC ? PRE_INC : PRE_DEC);
 			expr->addChild(exp);
 			
 			return expr;			
@@ -552,7 +550,7 @@ ASTNode *Parser::unary_expression() {
 				||
 				exp->type == MEMBER) 
 			{
-				ASTNode *expr = new ASTNode(get(-1)->lineno, get(-1)->token == INC ? POS_INC : POS_DEC);
+				ASTNode *expr = new (arena) ASTNode(get(-1)->lineno, get(-1)->token == INC ? POS_INC : POS_DEC);
 				expr->addChild(exp);
 				
 				return expr;
@@ -578,7 +576,7 @@ ASTNode *Parser::multiplication_expression() {
 	
 	while (1) {
 		if (match(MUL) || match(DIV) || match(MDIV) || match(MOD) || match(HASH)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = unary_expression();
 			
@@ -611,7 +609,7 @@ ASTNode *Parser::addiction_expression() {
 	
 	while (1) {
 		if (match(PLUS) || match(MINUS)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = multiplication_expression();
 			
@@ -644,7 +642,7 @@ ASTNode *Parser::bitwise_shift_expression() {
 	
 	while (1) {
 		if (match(BITRSH) || match(BITLSH) || match(BITURSH)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = addiction_expression();
 			
@@ -677,7 +675,7 @@ ASTNode *Parser::comparison_expression() {
 	
 	while (1) {
 		if (match(GT) || match(GE) || match(LT) || match(LE)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = bitwise_shift_expression();
 			
@@ -710,7 +708,7 @@ ASTNode *Parser::equality_expression() {
 	
 	while (1) {
 		if (match(EQ) || match(NEQ)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = comparison_expression();
 			
@@ -743,7 +741,7 @@ ASTNode *Parser::bitwise_and_expression() {
 	
 	while (1) {
 		if (match(BITAND)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = equality_expression();
 			
@@ -776,7 +774,7 @@ ASTNode *Parser::bitwise_xor_exppression() {
 	
 	while (1) {
 		if (match(BITXOR)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = bitwise_and_expression();
 			
@@ -809,7 +807,7 @@ ASTNode *Parser::bitwise_or_expression() {
 	
 	while (1) {
 		if (match(BITOR)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = bitwise_xor_exppression();
 			
@@ -842,7 +840,7 @@ ASTNode *Parser::and_expression() {
 	
 	while (1) {
 		if (match(AND)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = bitwise_or_expression();
 			
@@ -875,7 +873,7 @@ ASTNode *Parser::or_expression() {
 	
 	while (1) {
 		if (match(OR)) {
-			ASTNode *exp   = new ASTNode(get(-1)->lineno, get(-1)->token);
+			ASTNode *exp   = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 			exp->addChild(left);
 			ASTNode *right = and_expression();
 			
@@ -910,7 +908,7 @@ ASTNode *Parser::condition_expression() {
 	ASTNode *condition_exp;
 	
 	if (match(HOOK))
-		condition_exp = new ASTNode(get(-1)->lineno, CONDITION);
+		condition_exp = new (arena) ASTNode(get(-1)->lineno, CONDITION);
 	else 
 		return or_exp;
 	
@@ -987,7 +985,7 @@ ASTNode *Parser::assign_expression() {
 			condition_exp->type == FIELD
 			||
 			condition_exp->type == MEMBER)
-			assign_exp = new ASTNode(get(-1)->lineno, get(-1)->token);
+			assign_exp = new (arena) ASTNode(get(-1)->lineno, get(-1)->token);
 		else {
 			delete condition_exp;
 			return parser_error("Left side of the assignment expected to be field");
@@ -1074,7 +1072,7 @@ ASTNode *Parser::initializerstatement() {
 		// const safe local var a = 10;
 		//            ^ not used
 		
-		ASTNode *definenode = new ASTNode(get(-1)->lineno, DEFINE);
+		ASTNode *definenode = new (arena) ASTNode(get(-1)->lineno, DEFINE);
 		
 		// Modifiers
 		bool _var   = (get(-1)->token == VAR);
@@ -1098,7 +1096,7 @@ ASTNode *Parser::initializerstatement() {
 				return parser_error("Expected name");
 			}
 			
-			string *name = get(-1)->stringv->copy();
+			string *name = tokenString();
 			
 			if (match(ASSIGN)) {
 				_var = 1;
@@ -1107,7 +1105,6 @@ ASTNode *Parser::initializerstatement() {
 				
 				// Check for NULL expressin and ommit memory leak
 				if (error_) {
-					delete name;
 					delete definenode;
 					return NULL;
 				}
@@ -1116,8 +1113,7 @@ ASTNode *Parser::initializerstatement() {
 				_var = 0;
 			
 				
-			int *type = new int;
-			*type = (_var << 3) | (_safe << 2) | (_local << 1) | _const;
+			int *type = astObject<int>(arena, (_var << 3) | (_safe << 2) | (_local << 1) | _const);
 			definenode->addFirstObject(name);
 			definenode->addFirstObject(type);
 			
@@ -1135,7 +1131,7 @@ ASTNode *Parser::initializerstatement() {
 		// expression
 		
 		DEBUG("\\/ EXPRESSION STATEMENT node")
-		ASTNode *expst = new ASTNode(get(0)->lineno, EXPRESSION);
+		ASTNode *expst = new (arena) ASTNode(get(0)->lineno, EXPRESSION);
 		
 		// Check for NULL expressin and ommit memory leak
 		ASTNode *exp = checkNotNullExpression();
@@ -1214,7 +1210,7 @@ ASTNode *Parser::statement_with_semicolons() {
 	else if (match(SEMICOLON)) {
 		// printf("____ %d %d %d\n", get(-1)->token, get(0)->token, get(1)->token);
 		DEBUG("EMPTY node")
-		ASTNode *empty = new ASTNode(get(-1)->lineno, EMPTY);
+		ASTNode *empty = new (arena) ASTNode(get(-1)->lineno, EMPTY);
 		
 		return empty;
 	}
@@ -1226,7 +1222,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// ELSE node
 		
 		DEBUG("IF node")
-		ASTNode *ifelse = new ASTNode(get(-1)->lineno, IF);
+		ASTNode *ifelse = new (arena) ASTNode(get(-1)->lineno, IF);
 		// printf("lo lineno: %d %d\n", get(-1)->lineno);
 		int lp = match(LP);
 		
@@ -1251,7 +1247,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		if (match(ELSE))
 			elsenode = statement();
 		else {
-			elsenode = new ASTNode(-1, EMPTY);
+			elsenode = new (arena) ASTNode(-1, EMPTY);
 		}
 		
 		// Add nodes
@@ -1269,7 +1265,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// caseN
 		
 		DEBUG("SWITCH node")
-		ASTNode *switchcase = new ASTNode(get(-1)->lineno, SWITCH);
+		ASTNode *switchcase = new (arena) ASTNode(get(-1)->lineno, SWITCH);
 		int lp = match(LP);
 		
 		// Check for NULL expressin and ommit memory leak
@@ -1313,7 +1309,7 @@ ASTNode *Parser::statement_with_semicolons() {
 						return NULL;
 					}
 					
-					ASTNode *casenode = new ASTNode(lineno, CASE);
+					ASTNode *casenode = new (arena) ASTNode(lineno, CASE);
 					casenode->addChild(condition);
 					switchcase->addChild(casenode);
 					
@@ -1354,7 +1350,7 @@ ASTNode *Parser::statement_with_semicolons() {
 						return parser_error("Expected :");
 					}
 					
-					ASTNode *defaultnode = new ASTNode(lineno, DEFAULT);
+					ASTNode *defaultnode = new (arena) ASTNode(lineno, DEFAULT);
 					switchcase->addChild(defaultnode);
 					
 					while (true) {
@@ -1382,7 +1378,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		/*
 		// Insert default after condition
 		if (defaultnode == NULL) {
-			defaultnode = new ASTNode(-1, EMPTY);
+			defaultnode = new (arena) ASTNode(-1, EMPTY);
 		
 			// Add visitor function for this node
 			defaultnode->node_visit = NULL; // TODO: NODE_VISITOR
@@ -1401,7 +1397,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// BODY node
 		
 		DEBUG("WHILE node")
-		ASTNode *whileloop = new ASTNode(get(-1)->lineno, WHILE);
+		ASTNode *whileloop = new (arena) ASTNode(get(-1)->lineno, WHILE);
 		int lp = match(LP);
 		
 		// Check for NULL expressin and ommit memory leak
@@ -1433,7 +1429,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// BODY node
 		
 		DEBUG("DO WHILE node")
-		ASTNode *doloop = new ASTNode(get(-1)->lineno, DO);
+		ASTNode *doloop = new (arena) ASTNode(get(-1)->lineno, DO);
 		ASTNode *body   = statement();
 		
 		if (!match(WHILE)) {
@@ -1473,7 +1469,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// BODY node
 		
 		DEBUG("FOR node")
-		ASTNode *forloop = new ASTNode(get(-1)->lineno, FOR);
+		ASTNode *forloop = new (arena) ASTNode(get(-1)->lineno, FOR);
 		
 		if (!match(LP)) {
 			delete forloop;
@@ -1489,7 +1485,7 @@ ASTNode *Parser::statement_with_semicolons() {
 				return parser_error("Expected ;");
 			}
 		} else {
-			ASTNode *empty = new ASTNode(-1, EMPTY);
+			ASTNode *empty = new (arena) ASTNode(-1, EMPTY);
 			forloop->addChild(empty);
 		}
 		
@@ -1507,7 +1503,7 @@ ASTNode *Parser::statement_with_semicolons() {
 				return parser_error("Expected ;");
 			}
 		} else {
-			ASTNode *empty = new ASTNode(-1, EMPTY);
+			ASTNode *empty = new (arena) ASTNode(-1, EMPTY);
 			forloop->addChild(empty);
 		}
 		
@@ -1525,7 +1521,7 @@ ASTNode *Parser::statement_with_semicolons() {
 				return parser_error("Expected RP");
 			}
 		} else {
-			ASTNode *empty = new ASTNode(-1, EMPTY);
+			ASTNode *empty = new (arena) ASTNode(-1, EMPTY);
 			forloop->addChild(empty);
 		}
 		
@@ -1539,7 +1535,7 @@ ASTNode *Parser::statement_with_semicolons() {
 	}
 	
 	else if (match(LC)) { 
-		ASTNode *blocknode = new ASTNode(get(-1)->lineno, BLOCK);
+		ASTNode *blocknode = new (arena) ASTNode(get(-1)->lineno, BLOCK);
 		
 		while (true) {
 			if (error_) {
@@ -1562,7 +1558,7 @@ ASTNode *Parser::statement_with_semicolons() {
 	else if (match(BREAK)) {
 		
 		DEBUG("BREAK node");
-		ASTNode *breaknode = new ASTNode(get(-1)->lineno, BREAK);
+		ASTNode *breaknode = new (arena) ASTNode(get(-1)->lineno, BREAK);
 		
 		return breaknode;
 	}
@@ -1570,7 +1566,7 @@ ASTNode *Parser::statement_with_semicolons() {
 	else if (match(CONTINUE)) {
 		
 		DEBUG("CONTINUE node");
-		ASTNode *coontinuenode = new ASTNode(get(-1)->lineno, CONTINUE);
+		ASTNode *coontinuenode = new (arena) ASTNode(get(-1)->lineno, CONTINUE);
 		
 		return coontinuenode;
 	}
@@ -1581,7 +1577,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// FREAME:
 		// value / EMPTY
 		
-		ASTNode *returnnode = new ASTNode(get(-1)->lineno, RETURN);
+		ASTNode *returnnode = new (arena) ASTNode(get(-1)->lineno, RETURN);
 		
 		if (!peekStatementWithoutSemicolon() && get(0)->token != SEMICOLON) {
 			ASTNode *exp = checkNotNullExpression();
@@ -1603,10 +1599,10 @@ ASTNode *Parser::statement_with_semicolons() {
 		// FREAME:
 		// value / EMPTY
 		
-		ASTNode *raisenode = new ASTNode(get(-1)->lineno, RAISE);
+		ASTNode *raisenode = new (arena) ASTNode(get(-1)->lineno, RAISE);
 		
 		if (peekStatementWithoutSemicolon()) {
-			ASTNode *empty = new ASTNode(-1, EMPTY);
+			ASTNode *empty = new (arena) ASTNode(-1, EMPTY);
 			raisenode->addChild(empty);
 		} else {
 			ASTNode *exp = checkNotNullExpression();
@@ -1630,7 +1626,7 @@ ASTNode *Parser::statement_with_semicolons() {
 		// handler name / null
 		
 		DEBUG("TRY node")
-		ASTNode *tryexpect = new ASTNode(get(-1)->lineno, TRY);
+		ASTNode *tryexpect = new (arena) ASTNode(get(-1)->lineno, TRY);
 		tryexpect->addChild(statement());
 		
 		if (match(EXPECT)) {
@@ -1640,10 +1636,9 @@ ASTNode *Parser::statement_with_semicolons() {
 					return parser_error("Expected name");
 				}
 				
-				string *name = get(-1)->stringv->copy();
+				string *name = tokenString();
 				
 				if (!match(RP)) {
-					delete name;
 					delete tryexpect;
 					return parser_error("Expected )");
 				}
@@ -1653,7 +1648,7 @@ ASTNode *Parser::statement_with_semicolons() {
 			
 			tryexpect->addChild(statement());
 		} else {
-			ASTNode *empty = new ASTNode(-1, EMPTY);
+			ASTNode *empty = new (arena) ASTNode(-1, EMPTY);
 			tryexpect->addChild(empty);
 		}
 		
@@ -1665,7 +1660,7 @@ ASTNode *Parser::statement_with_semicolons() {
 };
 
 ASTNode *Parser::parse() {
-	ASTNode *root = new ASTNode(0, ASTROOT);
+	ASTNode *root = new (arena) ASTNode(0, ASTROOT);
 	
 	
 	//while (this->source->nextToken())
@@ -1694,9 +1689,163 @@ ASTNode *Parser::parse() {
 		return NULL;
 	}
 	
+	analyze(root, NULL);
+	for (ASTNode *node = root->left; node; node = node->next)
+		resolveNames(node, NULL);
+	
+	// Tree is disposed with it's arena by deleting the root
+	root->ownArena();
+	arena = NULL;
+	
 	return root;
 };
 
+// Returns true if name of NAME node is in the list
+static bool isKnown(ASTNode *name, ASTObjectList *known) {
+	for (ASTObjectList *l = known; l; l = l->next)
+		if (*(string*) l->object == *(string*) name->objectlist->object)
+			return true;
+	return false;
+};
+
+bool Parser::analyze(ASTNode *node, ASTObjectList *known) {
+	if (node == NULL)
+		return false;
+	
+	// Function arguments are defined on call
+	ASTObjectList *list = known;
+	if (node->type == FUNCTION)
+		for (ASTObjectList *l = node->objectlist; l; l = l->next)
+			list = new ASTObjectList(list, l->object);
+	
+	bool scope = false;
+	for (ASTNode *child = node->left; child; child = child->next) {
+		scope |= analyze(child, list);
+		
+		// Declaration statement of block / root / for initialization 
+		// always executes before the next children.
+		// DEFINE objects: type, name, type, name, ...
+		if (child->type == DEFINE && (node->type == BLOCK || node->type == ASTROOT || (node->type == FOR && child == node->left)))
+			for (ASTObjectList *l = child->objectlist; l && l->next; l = l->next->next)
+				list = new ASTObjectList(list, l->next->object);
+	}
+	
+	// Pop names, strings are owned by nodes
+	while (list != known) {
+		ASTObjectList *next = list->next;
+		delete list;
+		list = next;
+	}
+	
+	switch (node->type) {
+		// return f(...);
+		case RETURN:
+			if (node->left && node->left->type == CALL)
+				node->left->flags |= NODE_TAIL_CALL;
+			return scope;
+		
+		// Variable declaration or direct reference to the current Scope
+		case DEFINE:
+		case SELF:
+			return true;
+		
+		// Assignment to the name that is not found in enclosing 
+		// scopes defines it in the current Scope
+		case ASSIGN:
+		case ASSIGN_ADD:     case ASSIGN_SUB:
+		case ASSIGN_MUL:     case ASSIGN_DIV:
+		case ASSIGN_MDIV:    case ASSIGN_MOD:
+		case ASSIGN_BITRSH:  case ASSIGN_BITURSH: case ASSIGN_BITLSH:
+		case ASSIGN_BITAND:  case ASSIGN_BITOR:   case ASSIGN_BITXOR:
+		case POS_INC:        case POS_DEC:
+		case PRE_INC:        case PRE_DEC:
+			if (node->left && node->left->type == NAME && !isKnown(node->left, known))
+				return true;
+			return scope;
+		
+		// Function body gets own Scope on call
+		case FUNCTION:
+			return false;
+		
+		// Block without declarations and unknown assignments 
+		// can reuse enclosing Scope.
+		case BLOCK:
+		case FOR:
+			if (!scope)
+				node->flags |= NODE_SCOPE_FREE;
+			return false;
+		
+		default:
+			return scope;
+	}
+};
+
+// Nodes, creating own Scope for declarations inside
+static bool isFrameNode(ASTNode *node) {
+	return node->type == FUNCTION || node->type == BLOCK || node->type == FOR || node->type == TRY;
+};
+
+// Collects names declared inside of the frame node body into the list.
+// Does not descend into nested frames.
+static ASTObjectList *collectDeclared(ASTNode *node, ASTObjectList *list) {
+	for (ASTNode *child = node->left; child; child = child->next) {
+		if (isFrameNode(child))
+			continue;
+		
+		// DEFINE objects: type, name, type, name, ...
+		if (child->type == DEFINE)
+			for (ASTObjectList *l = child->objectlist; l && l->next; l = l->next->next)
+				list = new ASTObjectList(list, l->next->object);
+		
+		list = collectDeclared(child, list);
+	}
+	
+	return list;
+};
+
+void Parser::resolveNames(ASTNode *node, ASTObjectList *frames) {
+	if (node == NULL)
+		return;
+	
+	if (node->type == NAME && node->objectlist && !node->objectlist->next) {
+		string *name = (string*) node->objectlist->object;
+		
+		// Internal names (__parent, __arguments, ...) are frame-defined
+		if (name->length >= 2 && name->buffer[0] == '_' && name->buffer[1] == '_')
+			return;
+		
+		for (ASTObjectList *l = frames; l; l = l->next)
+			if (l->object && *(string*) l->object == *name)
+				return;
+		
+		node->addLastObject(astObject<ASTNameCache>(arena, ASTNameCache()));
+		return;
+	}
+	
+	if (!isFrameNode(node)) {
+		for (ASTNode *child = node->left; child; child = child->next)
+			resolveNames(child, frames);
+		return;
+	}
+	
+	// Push names of the frame: parameters / catch name / declared variables
+	ASTObjectList *list = frames;
+	if (node->type == FUNCTION || node->type == TRY)
+		for (ASTObjectList *l = node->objectlist; l; l = l->next)
+			list = new ASTObjectList(list, l->object);
+	list = collectDeclared(node, list);
+	
+	for (ASTNode *child = node->left; child; child = child->next)
+		resolveNames(child, list);
+	
+	// Pop frame names, strings are owned by nodes
+	while (list != frames) {
+		ASTObjectList *next = list->next;
+		delete list;
+		list = next;
+	}
+};
+
 int Parser::lineno() {
 	return get(0)->lineno;
 };
@@ -31,15 +31,23 @@ struct Parser {
 	TokenStream *source;
 	int           eof_ = 0;
 	int         error_ = 0;
+	// Set to 1 to suppress error messages (background parsing)
+	int        silent_ = 0;
 	
 	RawToken *buffer[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
 	
+	// Memory of the tree being parsed
+	Arena        *arena = NULL;
+	
 	void init(TokenStream *source);
 	
 	~Parser();
 	
 	RawToken *get(int off);
 	
+	// Returns text of the last matched token allocated in the arena
+	string *tokenString();
+	
 	RawToken *next();
 	
 	bool match(int token);
@@ -94,6 +102,18 @@ struct Parser {
 	
 	ASTNode *parse();
 	
+	// Computes ASTNode flags: marks BLOCK & FOR nodes that do not 
+	// require own Scope and CALL nodes in tail position.
+	// known is list of names, surely defined in enclosing scopes.
+	// Returns true if subtree declares variables in the enclosing Scope
+	// or assigns a name that is not known.
+	bool analyze(ASTNode *node, ASTObjectList *known);
+	
+	// Attaches ASTNameCache to NAME nodes that are not declared by 
+	// any enclosing function / block / catch and may refer to global.
+	// frames is list of names, declared by enclosing nodes.
+	void resolveNames(ASTNode *node, ASTObjectList *frames);
+	
 	int lineno();
 	
 	int eof();
@@ -0,0 +1,328 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "Profiler.h"
+#include "ASTExecuter.h"
+
+volatile sig_atomic_t _profiler_pending = 0;
+
+// Collapsed stack -> amount of samples
+struct ProfilerStack {
+	ProfilerStack *next;
+	char           *key;
+	int           count;
+};
+
+// file:line -> amount of samples
+struct ProfilerLine {
+	ProfilerLine *next;
+	const char   *file;
+	int         lineno;
+	int           self;
+	int          total;
+	// Last sample that counted this line in total
+	int         sample;
+};
+
+static ProfilerStack *profiler_stacks[PROFILER_TABLE_SIZE];
+static ProfilerLine  *profiler_lines [PROFILER_TABLE_SIZE];
+static int            profiler_samples = 0;
+static char          *profiler_path    = NULL;
+static bool           profiler_running = 0;
+
+// Interned file names, compared by pointer
+struct ProfilerFile {
+	ProfilerFile *next;
+	char         *name;
+};
+
+static ProfilerFile *profiler_files = NULL;
+
+static void profiler_handler(int signum) {
+	_profiler_pending = 1;
+};
+
+static unsigned int profiler_hash(const char *s) {
+	unsigned int h = 2166136261u;
+	while (*s) {
+		h ^= (unsigned char) *s++;
+		h *= 16777619u;
+	}
+	return h;
+};
+
+// Appends frame name to the buffer, replacing characters
+// that are not allowed in collapsed stack format.
+static int profiler_append(char *buffer, int length, int size, string *name) {
+	for (int i = 0; i < name->length && length < size - 1; ++i) {
+		wchar_t c = name->buffer[i];
+		buffer[length++] = c == ';' || c == ' ' || c == '\n' ? '_' : c < 128 ? (char) c : '?';
+	}
+	buffer[length] = 0;
+	return length;
+};
+
+static const char *profiler_file(string *name) {
+	char buffer[1024];
+	profiler_append(buffer, 0, sizeof(buffer), name);
+
+	for (ProfilerFile *f = profiler_files; f; f = f->next)
+		if (!::strcmp(f->name, buffer))
+			return f->name;
+
+	ProfilerFile *f = new ProfilerFile;
+	f->name         = strdup(buffer);
+	f->next         = profiler_files;
+	profiler_files  = f;
+	return f->name;
+};
+
+static void profiler_count_stack(const char *key) {
+	unsigned int h = profiler_hash(key) % PROFILER_TABLE_SIZE;
+
+	for (ProfilerStack *s = profiler_stacks[h]; s; s = s->next)
+		if (!::strcmp(s->key, key)) {
+			++s->count;
+			return;
+		}
+
+	ProfilerStack *s   = new ProfilerStack;
+	s->key             = strdup(key);
+	s->count           = 1;
+	s->next            = profiler_stacks[h];
+	profiler_stacks[h] = s;
+};
+
+static void profiler_count_line(const char *file, int lineno, bool self) {
+	unsigned int h = ((unsigned long) file * 31 + lineno) % PROFILER_TABLE_SIZE;
+	ProfilerLine *l = profiler_lines[h];
+
+	while (l && (l->file != file || l->lineno != lineno))
+		l = l->next;
+
+	if (!l) {
+		l                 = new ProfilerLine;
+		l->file           = file;
+		l->lineno         = lineno;
+		l->self           = 0;
+		l->total          = 0;
+		l->sample         = -1;
+		l->next           = profiler_lines[h];
+		profiler_lines[h] = l;
+	}
+
+	if (self)
+		++l->self;
+
+	// Recursion counts line once per sample
+	if (l->sample != profiler_samples) {
+		l->sample = profiler_samples;
+		++l->total;
+	}
+};
+
+void profiler_start(const char *path) {
+	profiler_path    = strdup(path ? path : PROFILER_DEFAULT_OUTPUT);
+	profiler_running = 1;
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = profiler_handler;
+	sa.sa_flags   = SA_RESTART;
+	sigaction(SIGPROF, &sa, NULL);
+
+	struct itimerval timer;
+	timer.it_interval.tv_sec  = 0;
+	timer.it_interval.tv_usec = PROFILER_INTERVAL;
+	timer.it_value            = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, NULL);
+};
+
+void profiler_sample(ASTExecuter *executer) {
+	_profiler_pending = 0;
+
+	if (!profiler_running)
+		return;
+
+	// Collect trace records top -> root.
+	// Deep stack keeps the innermost frames and the root frame,
+	// frames between them are replaced with [truncated].
+	ASTExecuterStackTraceElement *frames[PROFILER_MAX_DEPTH];
+	int depth = 0;
+
+	// Root frame, the outermost truncated frame
+	// and the innermost file among truncated frames
+	ASTExecuterStackTraceElement *root            = NULL;
+	ASTExecuterStackTraceElement *truncated_outer = NULL;
+	ASTExecuterStackTraceElement *truncated_file  = NULL;
+
+	ASTExecuterStackTraceElement *e = executer->aststacktrace->head;
+	for (int i = 0; e && i < executer->aststacktrace->pos_size; ++i, e = e->next)
+		if (depth < PROFILER_MAX_DEPTH - 1)
+			frames[depth++] = e;
+		else {
+			if (root) {
+				truncated_outer = root;
+				if (!truncated_file && root->type == ASTESTE_FILE)
+					truncated_file = root;
+			}
+			root = e;
+		}
+
+	if (root)
+		frames[depth++] = root;
+
+	// Line of the currently executed node
+	int lineno = -1;
+	for (ASTExecuterElement *el = executer->aststack->head; el && lineno < 0; el = el->next)
+		if (el->attached_node)
+			lineno = el->attached_node->lineno;
+
+	char stack[PROFILER_MAX_DEPTH * 64];
+	int length       = 0;
+	const char *file = "?";
+	stack[0]         = 0;
+
+	// Call site line of frame i belongs to the code of frame i - 1
+	for (int i = depth - 1; i >= 0; --i) {
+		ASTExecuterStackTraceElement *f = frames[i];
+
+		// The first frame after [truncated] is called from unknown line
+		if (f->type == ASTESTE_FILE)
+			file = profiler_file(&f->tracename);
+		else if (f->tracelineno >= 0 && !(truncated_outer && i == depth - 2))
+			profiler_count_line(file, f->tracelineno, 0);
+
+		if (length && length < sizeof(stack) - 1)
+			stack[length++] = ';';
+
+		if (f->type == ASTESTE_UNDEFINED) {
+			string anonymous("<anonymous>");
+			length = profiler_append(stack, length, sizeof(stack), &anonymous);
+		} else
+			length = profiler_append(stack, length, sizeof(stack), &f->tracename);
+
+		// Inner frames continue in the code of truncated frames
+		if (truncated_outer && i == depth - 1) {
+			if (truncated_outer->type != ASTESTE_FILE && truncated_outer->tracelineno >= 0)
+				profiler_count_line(file, truncated_outer->tracelineno, 0);
+
+			string marker("[truncated]");
+			if (length < sizeof(stack) - 1)
+				stack[length++] = ';';
+			length = profiler_append(stack, length, sizeof(stack), &marker);
+
+			if (truncated_file)
+				file = profiler_file(&truncated_file->tracename);
+		}
+	}
+
+	if (lineno >= 0)
+		profiler_count_line(file, lineno, 1);
+
+	profiler_count_stack(length ? stack : "<root>");
+	++profiler_samples;
+};
+
+static int profiler_compare_lines(const void *a, const void *b) {
+	ProfilerLine *x = *(ProfilerLine**) a;
+	ProfilerLine *y = *(ProfilerLine**) b;
+
+	if (x->self != y->self)
+		return y->self - x->self;
+	return y->total - x->total;
+};
+
+void profiler_stop() {
+	if (!profiler_running)
+		return;
+	profiler_running = 0;
+
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+	signal(SIGPROF, SIG_IGN);
+
+	// Collapsed stacks
+	FILE *out = fopen(profiler_path, "w");
+	if (out) {
+		for (int i = 0; i < PROFILER_TABLE_SIZE; ++i)
+			for (ProfilerStack *s = profiler_stacks[i]; s; s = s->next)
+				fprintf(out, "%s %d\n", s->key, s->count);
+		fclose(out);
+	} else
+		fprintf(stderr, "Profiler: can not write %s\n", profiler_path);
+
+	// Per-line table
+	int count = 0;
+	for (int i = 0; i < PROFILER_TABLE_SIZE; ++i)
+		for (ProfilerLine *l = profiler_lines[i]; l; l = l->next)
+			++count;
+
+	ProfilerLine **lines = (ProfilerLine**) malloc((count + 1) * sizeof(ProfilerLine*));
+	count = 0;
+	for (int i = 0; i < PROFILER_TABLE_SIZE; ++i)
+		for (ProfilerLine *l = profiler_lines[i]; l; l = l->next)
+			lines[count++] = l;
+
+	qsort(lines, count, sizeof(ProfilerLine*), profiler_compare_lines);
+
+	int samples = profiler_samples ? profiler_samples : 1;
+	fprintf(stderr, "\nProfile: %d samples, %d us interval, stacks in %s\n", profiler_samples, PROFILER_INTERVAL, profiler_path);
+	fprintf(stderr, "%7s %7s %7s %7s  %s\n", "self%", "self", "total%", "total", "line");
+
+	for (int i = 0; i < count && i < PROFILER_TABLE_LINES; ++i)
+		fprintf(stderr, "%6.2f%% %7d %6.2f%% %7d  %s:%d\n",
+			100.0 * lines[i]->self / samples, lines[i]->self,
+			100.0 * lines[i]->total / samples, lines[i]->total,
+			lines[i]->file, lines[i]->lineno);
+
+	free(lines);
+
+	// Dispose tables
+	for (int i = 0; i < PROFILER_TABLE_SIZE; ++i) {
+		while (profiler_stacks[i]) {
+			ProfilerStack *s = profiler_stacks[i]->next;
+			free(profiler_stacks[i]->key);
+			delete profiler_stacks[i];
+			profiler_stacks[i] = s;
+		}
+		while (profiler_lines[i]) {
+			ProfilerLine *l = profiler_lines[i]->next;
+			delete profiler_lines[i];
+			profiler_lines[i] = l;
+		}
+	}
+
+	while (profiler_files) {
+		ProfilerFile *f = profiler_files->next;
+		free(profiler_files->name);
+		delete profiler_files;
+		profiler_files = f;
+	}
+
+	free(profiler_path);
+	profiler_path    = NULL;
+	profiler_samples = 0;
+};
@@ -0,0 +1,59 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Sampling profiler for scripts (ck --profile).
+ * SIGPROF timer only raises flag, script stack is read by executer
+ * on the next visit from ASTExecuterStackTrace, so handler does not
+ * touch any executer structures.
+ * Output is collapsed stacks (flamegraph.pl / speedscope) and
+ * per-line self / total table printed on exit.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <signal.h>
+
+// Sampling interval in microseconds
+#define PROFILER_INTERVAL    1000
+// Max amount of stack frames recorded for single sample,
+// deeper stacks keep the root frame and the innermost frames
+#define PROFILER_MAX_DEPTH   128
+// Amount of buckets in profiler hash tables
+#define PROFILER_TABLE_SIZE  4096
+// Amount of lines printed in per-line table
+#define PROFILER_TABLE_LINES 30
+
+// Default output file for collapsed stacks
+#define PROFILER_DEFAULT_OUTPUT "ck.profile.folded"
+
+struct ASTExecuter;
+
+// set to 1 by SIGPROF handler when sample should be taken
+extern volatile sig_atomic_t _profiler_pending;
+
+// Starts sampling timer, stacks will be written into the given file
+void profiler_start(const char *path);
+
+// Records current script stack of the executer
+void profiler_sample(ASTExecuter *executer);
+
+// Stops timer, writes collapsed stacks & prints per-line table
+void profiler_stop();
+
+#endif
@@ -25,6 +25,9 @@
 #include "TokenNamespace.h"
 #include "string.h"
 
+// Token is plain value allocated from TokenStream arena.
+// Names & strings without escapes refer to the source text,
+// escaped strings are decoded into the arena.
 struct RawToken {
 	int       token;
 	int    integerv;
@@ -32,25 +35,24 @@ struct RawToken {
 	int       bytev;
 	int    booleanv;
 	double  doublev;
-	string *stringv;
+	// Text of name / string / flag, not terminated
+	const wchar_t *text;
+	int          length;
 	int      lineno;
 	
-	~RawToken() {
-		delete stringv;
+	// Returns new string with text of the token
+	string *toString() {
+		return new string(text, length);
 	};
 	
-	RawToken *copy() {
-		RawToken *cpy = new RawToken;
-		cpy->token    = this->token;
-		cpy->integerv = this->integerv;
-		cpy->longv    = this->longv;
-		cpy->bytev    = this->bytev;
-		cpy->booleanv = this->booleanv;
-		cpy->doublev  = this->doublev;
-		cpy->stringv  = this->stringv->copy();
-		cpy->lineno   = this->lineno;
-		return cpy;
+	// Compares text of the token with ASCII string
+	bool equals(const char *s) {
+		int i = 0;
+		for (; i < length; ++i)
+			if (!s[i] || text[i] != s[i])
+				return 0;
+		return !s[i];
 	};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -17,6 +17,8 @@
 */
 
 
+#include <cstdio>
+
 #include "TokenNamespace.h"
 
 const char *tokenToString(int token) {
@@ -258,3 +260,37 @@ const char *tokenToString(int token) {
 			return "";
 	}
 };
+
+const char *typeToString(int type, char *buffer, int size) {
+	switch (type) {
+		case INTEGER:                   return "Integer";
+		case DOUBLE:                    return "Double";
+		case BOOLEAN:                   return "Boolean";
+		case STRING:                    return "String";
+		case ARRAY:                     return "Array";
+		case OBJECT:                    return "Object";
+		case SCOPE:                     return "Scope";
+		case PROXY_SCOPE:               return "ProxyScope";
+		case CALL_SCOPE:                return "CallScope";
+		case CODE_FUNCTION:             return "CodeFunction";
+		case NATIVE_FUNCTION:           return "NativeFunction";
+		case TNULL:                     return "Null";
+		case UNDEFINED:                 return "Undefined";
+		case ERROR:                     return "Error";
+		case STRING_PROTOTYPE:          return "String.prototype";
+		case DOUBLE_PROTOTYPE:          return "Double.prototype";
+		case NULL_PROTOTYPE:            return "Null.prototype";
+		case OBJECT_PROTOTYPE:          return "Object.prototype";
+		case SCOPE_PROTOTYPE:           return "Scope.prototype";
+		case CODE_FUNCTION_PROTOTYPE:   return "CodeFunction.prototype";
+		case NATIVE_FUNCTION_PROTOTYPE: return "NativeFunction.prototype";
+		case INTEGER_PROTOTYPE:         return "Integer.prototype";
+		case BOOLEAN_PROTOTYPE:         return "Boolean.prototype";
+		case UNDEFINED_PROTOTYPE:       return "Undefined.prototype";
+		case ARRAY_PROTOTYPE:           return "Array.prototype";
+		case ERROR_PROTOTYPE:           return "Error.prototype";
+	}
+	
+	snprintf(buffer, size, "<type %d>", type);
+	return buffer;
+};
@@ -57,6 +57,7 @@
 #define ARRAY_PROTOTYPE            38
 #define ERROR                      39
 #define ERROR_PROTOTYPE            40
+#define CALL_SCOPE                 41
 
 // Keywords
 
@@ -174,6 +175,10 @@
 // Returns consta char* string representation of given token type
 const char *tokenToString(int);
 
+// Returns name of VirtualObject::type value.
+// Name of unknown type is written into the buffer as <type N>.
+const char *typeToString(int type, char *buffer, int size);
+
 //     _      _      _
 //  __(.)< __(.)> __(.)=
 //  \___)  \___)  \___)   krya-krya
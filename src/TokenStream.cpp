@@ -17,6 +17,8 @@
 */
 
 
+#include <cmath>
+
 #include "TokenStream.h"
 #include "FakeStream.h"
 #include "RawToken.h"
@@ -39,12 +41,161 @@ static int digit(int c) {
 	return c >= '0' && c <= '9';
 };
 
-static char strtlc(char c) {
-	return (c >= 'a' && c <= 'z') ? c + 'A' - 'a' : c;
+// Value of hexadecimal digit or -1
+static int hex(int c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+};
+
+// Converts validated digits of integer
+static long long integer(const wchar_t *s, int n, int base) {
+	long long value = 0;
+	for (int i = 0; i < n; ++i)
+		value = value * base + hex(s[i]);
+	return value;
+};
+
+// Converts validated decimal double: 12, 1.5, .5, 1e-3
+static double decimal(const wchar_t *s, int n) {
+	// Significand keeps 18 digits, the rest only change exponent
+	unsigned long long m = 0;
+	int exp = 0;
+	int i   = 0;
+	
+	for (; i < n && digit(s[i]); ++i)
+		if (m < 100000000000000000ull)
+			m = m * 10 + (s[i] - '0');
+		else
+			++exp;
+	
+	if (i < n && s[i] == '.')
+		for (++i; i < n && digit(s[i]); ++i)
+			if (m < 100000000000000000ull) {
+				m = m * 10 + (s[i] - '0');
+				--exp;
+			}
+	
+	if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+		bool neg = 0;
+		int  e   = 0;
+		++i;
+		if (i < n && (s[i] == '-' || s[i] == '+'))
+			neg = s[i++] == '-';
+		for (; i < n && digit(s[i]); ++i)
+			if (e < 100000)
+				e = e * 10 + (s[i] - '0');
+		exp += neg ? -e : e;
+	}
+	
+	double d = (double) m;
+	if (!m || !exp)
+		return d;
+	
+	// Powers of 10 up to 1e22 are exact, result is correctly rounded
+	if (exp < 0)
+		return exp >= -22 ? d / pow(10.0, -exp) : d * pow(10.0, exp);
+	return d * pow(10.0, exp);
+};
+
+struct Keyword {
+	const char *name;
+	int       length;
+	int        token;
+};
+
+// Size of keyword_table, power of 2
+#define KEYWORD_SLOTS 64
+#define KEYWORD_NONE  { NULL, 0, NAME }
+
+// Perfect hash of keyword by length, first and last chars.
+// Multipliers are picked so that every keyword gets own slot,
+// after changing keywords pick new ones and reorder the table.
+static constexpr int keyword_hash(int first, int last, int length) {
+	return (length + first * 9 + last * 57) & (KEYWORD_SLOTS - 1);
+};
+
+// Keywords placed by keyword_hash
+static constexpr Keyword keyword_table[KEYWORD_SLOTS] = {
+	/*  0 */ { "continue",  8, CONTINUE  },
+	/*  1 */ KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE,
+	/*  4 */ { "raise",     5, RAISE     },
+	/*  5 */ { "self",      4, SELF      },
+	/*  6 */ { "return",    6, RETURN    },
+	/*  7 */ KEYWORD_NONE,
+	/*  8 */ { "try",       3, TRY       },
+	/*  9 */ KEYWORD_NONE,
+	/* 10 */ { "break",     5, BREAK     },
+	/* 11 */ { "var",       3, VAR       },
+	/* 12 */ { "safe",      4, SAFE      },
+	/* 13 */ KEYWORD_NONE,
+	/* 14 */ { "else",      4, ELSE      },
+	/* 15 */ KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE,
+	/* 20 */ { "const",     5, CONST     },
+	/* 21 */ { "true",      4, TRUE      },
+	/* 22 */ KEYWORD_NONE, KEYWORD_NONE,
+	/* 24 */ { "false",     5, FALSE     },
+	/* 25 */ KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE,
+	/* 28 */ { "function",  8, FUNCTION  },
+	/* 29 */ { "local",     5, LOCAL     },
+	/* 30 */ KEYWORD_NONE,
+	/* 31 */ { "default",   7, DEFAULT   },
+	/* 32 */ { "new",       3, NEW       },
+	/* 33 */ KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE,
+	/* 39 */ { "expect",    6, EXPECT    },
+	/* 40 */ KEYWORD_NONE,
+	/* 41 */ { "if",        2, IF        },
+	/* 42 */ { "undefined", 9, UNDEFINED },
+	/* 43 */ KEYWORD_NONE, KEYWORD_NONE, KEYWORD_NONE,
+	/* 46 */ { "null",      4, TNULL     },
+	/* 47 */ KEYWORD_NONE, KEYWORD_NONE,
+	/* 49 */ { "while",     5, WHILE     },
+	/* 50 */ KEYWORD_NONE,
+	/* 51 */ { "this",      4, THIS      },
+	/* 52 */ KEYWORD_NONE, KEYWORD_NONE,
+	/* 54 */ { "prototype", 9, PROTOTYPE },
+	/* 55 */ KEYWORD_NONE, KEYWORD_NONE,
+	/* 57 */ { "switch",    6, SWITCH    },
+	/* 58 */ KEYWORD_NONE,
+	/* 59 */ { "for",       3, FOR       },
+	/* 60 */ { "case",      4, CASE      },
+	/* 61 */ { "do",        2, DO        },
+	/* 62 */ KEYWORD_NONE, KEYWORD_NONE
+};
+
+// Checks that every keyword is in it's slot and has valid length
+static constexpr bool keyword_table_valid(int i) {
+	return i == KEYWORD_SLOTS
+		|| ((!keyword_table[i].name
+			|| (keyword_table[i].name[keyword_table[i].length] == 0
+				&& keyword_hash(keyword_table[i].name[0], keyword_table[i].name[keyword_table[i].length - 1], keyword_table[i].length) == i))
+			&& keyword_table_valid(i + 1));
+};
+
+static_assert(keyword_table_valid(0), "keyword_table does not match keyword_hash");
+
+// Returns keyword token of the name or NAME
+static int keyword(const wchar_t *name, int length) {
+	const Keyword *k = &keyword_table[keyword_hash(name[0], name[length - 1], length)];
+	
+	if (k->length != length)
+		return NAME;
+	
+	for (int i = 0; i < length; ++i)
+		if (name[i] != k->name[i])
+			return NAME;
+	
+	return k->token;
 };
 
 TokenStream::TokenStream() {
-	buffer[0] = buffer[1] = buffer[2] = buffer[3] = buffer[4] = buffer[5] = buffer[6] = buffer[7] = buffer[8] = 0;
+	text   = NULL;
+	length = 0;
+	pos    = 0;
 };
 
 void TokenStream::init(FAKESTREAM *source) {
@@ -53,61 +204,68 @@ void TokenStream::init(FAKESTREAM *source) {
 	lineno = 1;
 	this->source = source;
 	
-	this->token          = new RawToken;
-	this->token->lineno  = 1;
-	this->token->stringv = NULL;
+	// Scan from current position of the source
+	text   = source->string + source->cursor;
+	length = source->length - source->cursor;
+	pos    = -5;
+	
+	arena.clear();
+	this->token = NULL;
+	clear();
 	next(); next(); next(); next(); next(); 
 };
 
-TokenStream::~TokenStream() {
-	delete token;
-};
+TokenStream::~TokenStream() {};
 
 int TokenStream::get(int off) {
 	if (off > 4 || off < -4)
 		Kit_bug(__LINE__);
-	return buffer[4 + off];
+	
+	int i = pos + off;
+	if (i < 0)
+		return 0;
+	if (i >= length)
+		return TEOF;
+	return text[i];
 };
 
 int TokenStream::next() {
-	for (int i = 1; i < 9; i++)
-		buffer[i - 1] = buffer[i];
-	
-	if (buffer[7] == TEOF)
-		buffer[8] = TEOF;
-	else {
-		int c = source->getc();
-		
-		if (c == WEOF)
-			buffer[8] = TEOF;
-		else
-			buffer[8] = c;
-	}
+	if (pos < length)
+		++pos;
 	
 	#ifdef PRINT_FILE
-	if (buffer[8] != TEOF) {			
-		putchar((char) buffer[8]);
+	if (pos + 4 < length) {			
+		putchar((char) text[pos + 4]);
 	} else if (eof())
 		putchar(10);
 	#endif
 	
-	if (buffer[4] == '\n') {
+	if (pos < 0)
+		return 0;
+	
+	if (pos >= length)
+		return TEOF;
+	
+	if (text[pos] == '\n') {
 		++lineno;
 		return TEOL;
 	}
 	
-	return buffer[4];
+	return text[pos];
 };
 
 void TokenStream::clear() {
-	delete token->stringv;
+	// Previous tokens are kept by Parser till the end of parsing
+	token = (RawToken*) arena.alloc(sizeof(RawToken));
 	token->token    = NONE;
 	token->integerv = 0;
 	token->longv    = 0;
 	token->bytev    = 0;
 	token->doublev  = 0.0;
 	token->booleanv = false;
-	token->stringv  = new string;
+	token->text     = NULL;
+	token->length   = 0;
+	token->lineno   = lineno;
 };
 
 int TokenStream::put(int token) {
@@ -124,32 +282,11 @@ int TokenStream::put(int token) {
 	return 1;
 };
 
-int TokenStream::match(int charcode0) {
-	if (get(0) != charcode0)
-		return false;
+int TokenStream::delimiter(int length, int token) {
+	// Delimiter has no newlines, only the last step may reach one
+	pos += length - 1;
 	next();
-	return true;
-};
-
-int TokenStream::match(int charcode0, int charcode1) {
-	if (get(0) != charcode0 || get(1) != charcode1)
-		return false;
-	next(); next();
-	return true;
-};
-
-int TokenStream::match(int charcode0, int charcode1, int charcode2) {
-	if (get(0) != charcode0 || get(1) != charcode1 || get(2) != charcode2)
-		return false;
-	next(); next(); next();
-	return true;
-};
-
-int TokenStream::match(int charcode0, int charcode1, int charcode2, int charcode3) {
-	if (get(0) != charcode0 || get(1) != charcode1 || get(2) != charcode2 || get(3) != charcode3)
-		return false;
-	next(); next(); next(); next();
-	return true;
+	return put(token);
 };
 
 int TokenStream::eof() {
@@ -157,9 +294,11 @@ int TokenStream::eof() {
 };
 
 int TokenStream::tokenizer_error(int lineno, const char *msg) {
-	chighred;
-	printf("Tokenizer error at %d : %s\n", lineno, msg);
-	creset;
+	if (!silent_) {
+		chighred;
+		printf("Tokenizer error at %d : %s\n", lineno, msg);
+		creset;
+	}
 	
 	error_ = true;
 	token->token = TERR;
@@ -168,7 +307,8 @@ int TokenStream::tokenizer_error(int lineno, const char *msg) {
 
 // Fur strings aka 'unexpected char 'c' at line...'
 int TokenStream::tokenizer_error(int lineno, const char *msg1, int c, const char *msg2) {
-	printf("Tokenizer error at %d : %s '%c' (%d) %s\n", lineno, msg1, c, c, msg2);
+	if (!silent_)
+		printf("Tokenizer error at %d : %s '%c' (%d) %s\n", lineno, msg1, c, c, msg2);
 	
 	error_ = true;
 	token->token = TERR;
@@ -176,13 +316,12 @@ int TokenStream::tokenizer_error(int lineno, const char *msg1, int c, const char
 };
 
 int TokenStream::nextToken() {
+	clear();
+	
 	if (eof() || !_global_exec_state)
 		return put(TEOF);
 	
-	clear();
-	
 	if (get(0) == TEOF) {
-		token->lineno = lineno;
 		this->eof_ = 1;
 		return put(TEOF);
 	}
@@ -245,69 +384,18 @@ int TokenStream::nextToken() {
 	/* K E Y W O R D S */ {
 		// Parse keywords|names
 		if (alpha(c)) {
-			string &stringvref = *token->stringv;
-			do {
-				stringvref += (char) c;
-				c = next();
-			} while((alpha(c) || digit(c)) && c != TEOF);
-
-			if (stringvref == "true")
-				return put(TRUE);
-			if (stringvref == "false")
-				return put(FALSE);
-			if (stringvref == "null")
-				return put(TNULL);
-			if (stringvref == "undefined")
-				return put(UNDEFINED);
-
-			if (stringvref == "this")
-				return put(THIS);
-			if (stringvref == "self")
-				return put(SELF);
-			if (stringvref == "try")
-				return put(TRY);
-			if (stringvref == "expect")
-				return put(EXPECT);
-			if (stringvref == "raise")
-				return put(RAISE);
-			if (stringvref == "if")
-				return put(IF);
-			if (stringvref == "else")
-				return put(ELSE);
-			if (stringvref == "for")
-				return put(FOR);
-			if (stringvref == "switch")
-				return put(SWITCH);
-			if (stringvref == "case")
-				return put(CASE);
-			if (stringvref == "default")
-				return put(DEFAULT);
-			if (stringvref == "while")
-				return put(WHILE);
-			if (stringvref == "do")
-				return put(DO);
-			if (stringvref == "break")
-				return put(BREAK);
-			if (stringvref == "continue")
-				return put(CONTINUE);
-			if (stringvref == "return")
-				return put(RETURN);
-			if (stringvref == "function")
-				return put(FUNCTION);
-			if (stringvref == "prototype")
-				return put(PROTOTYPE);
-			if (stringvref == "var")
-				return put(VAR);
-			if (stringvref == "const")
-				return put(CONST);
-			if (stringvref == "safe")
-				return put(SAFE);
-			if (stringvref == "local")
-				return put(LOCAL);
-			if (stringvref == "new")
-				return put(NEW);
-
-			return put(NAME);
+			// Name has no newlines, scan it in place
+			int end = pos + 1;
+			while (end < length && (alpha(text[end]) || digit(text[end])))
+				++end;
+			
+			token->text   = text + pos;
+			token->length = end - pos;
+			
+			pos = end - 1;
+			next();
+			
+			return put(keyword(token->text, token->length));
 		}
 	}
 	
@@ -315,60 +403,81 @@ int TokenStream::nextToken() {
 		// Parse string ("|')
 		if (c == '\'' || c == '\"') {
 			int quote = c;
-			string &stringvref = *token->stringv;
-
-			c = next();
-			while (c != TEOF) {
-				if (c == TEOL || c == TEOF)
-					return tokenizer_error(lineno, "string expected to be closed");
-				if (c == quote)
-					break;
-				if (c == '\\') {
-					c1 = next();
+			int start = pos + 1;
+			int end   = start;
+			bool escaped = 0;
+			
+			// Find closing quote, string can not contain newline
+			while (end < length && text[end] != quote && text[end] != '\n')
+				if (text[end] == '\\') {
+					if (end + 1 >= length || text[end + 1] == '\n')
+						return tokenizer_error(lineno, "unexpected character after escape point", end + 1 < length ? TEOL : TEOF, "");
+					escaped = 1;
+					end    += 2;
+				} else
+					++end;
+			
+			if (end >= length || text[end] != quote)
+				return tokenizer_error(lineno, "string expected to be closed");
+			
+			if (!escaped) {
+				token->text   = text + start;
+				token->length = end - start;
+			} else {
+				// Decoded string is not longer than source
+				wchar_t *buffer = (wchar_t*) arena.alloc((end - start) * sizeof(wchar_t));
+				int n = 0;
+				
+				for (int i = start; i < end; ++i) {
+					if (text[i] != '\\') {
+						buffer[n++] = text[i];
+						continue;
+					}
+					
+					int c1 = text[++i];
 					if (c1 == 't')
-						stringvref += '\t';
+						buffer[n++] = '\t';
 					else if (c1 == 'b')
-						stringvref += '\b';
+						buffer[n++] = '\b';
 					else if (c1 == 'n')
-						stringvref += '\n';
+						buffer[n++] = '\n';
 					else if (c1 == 'r')
-						stringvref += '\r';
+						buffer[n++] = '\r';
 					else if (c1 == 'f')
-						stringvref += '\f';
+						buffer[n++] = '\f';
 					else if (c1 == '\\')
-						stringvref += '\\';
+						buffer[n++] = '\\';
 					else if (c1 == '\'')
-						stringvref += '\'';
+						buffer[n++] = '\'';
 					else if (c1 == '\"')
-						stringvref += '\"';
+						buffer[n++] = '\"';
 					else if (c1 == '0')
-						stringvref += '\0';
+						buffer[n++] = '\0';
 					else if (c1 == 'u') {
-						c1 = next();
-						// Expect 4-digit hex number
+						// Expect up to 8-digit hex number
 						int chpoint = 0;
 						int point   = 0;
-						for (int i = 0; i < 8; i++) {
-							c1 = strtlc(c1);
-							int cp = -1;
-							if (c1 >= 'a' && c1 <= 'f')
-								cp = 10 + c1 - 'a';
-							if (c1 >= '0' && c1 <= '9')
-								cp = c1 - '0';
-							if (cp == -1 && !point)
-								return tokenizer_error(lineno, "expected hexadecimal character code point", c1, "");
+						while (point < 8 && i + 1 < end) {
+							int cp = hex(text[i + 1]);
 							if (cp == -1)
 								break;
 							++point;
+							++i;
 							chpoint = chpoint * 16 + cp;
-							c1 = next();
 						}
+						if (!point)
+							return tokenizer_error(lineno, "expected hexadecimal character code point", i + 1 < end ? text[i + 1] : quote, "");
+						buffer[n++] = chpoint;
 					} else
 						return tokenizer_error(lineno, "unexpected character after escape point", c1, "");
-				} else
-					stringvref += (wchar_t) c;
-				c = next();
+				}
+				
+				token->text   = buffer;
+				token->length = n;
 			}
+			
+			// Literal has no newlines, skip it with closing quote
+			pos = end;
 			next();
 			return put(STRING);
 		}
@@ -385,16 +494,19 @@ int TokenStream::nextToken() {
 			int hasPoint = false;
 			int scientific = false;
 			int base = 10;
-
-			string &stringvref = *token->stringv;
+			
+			// Number is converted from source text:
+			// start - first char, digits - first digit after base prefix,
+			// end - end of the number without suffix
+			int start  = pos;
+			int digits = pos;
+			int end    = -1;
 			
 			if (c == '.') {
 				type = DOUBLE;
 				hasPoint = true;
 			}
 
-			stringvref += (char) c;
-
 			c = next();
 			c1 = get(1);
 			while (c != TEOF) {
@@ -409,33 +521,32 @@ int TokenStream::nextToken() {
 						return tokenizer_error(lineno, "unexpected fraction of double nomber");
 					type = DOUBLE;
 					hasPoint = true;
-					stringvref += '.';
 				} else if ((c == 'x' || c == 'X') && base == 10) {
 					if (type == DOUBLE)
 						return tokenizer_error(lineno, "double can't be not decimal");
 					// if (base != 10)
 					//	return tokenizer_error(lineno, "one token.integerv can't have multiple numerical bases");
-					if (stringvref != "0")
+					if (pos - start != 1 || text[start] != '0')
 						return tokenizer_error(lineno, "base notation starts with 0");
-					stringvref = "";
+					digits = pos + 1;
 					base = 16;
 				} else if ((c == 'o' || c == 'O') && base == 10) {
 					if (type == DOUBLE)
 						return tokenizer_error(lineno, "double can't be not decimal");
 					// if (base != 10)
 					//	return tokenizer_error(lineno, "one token.integerv can't have multiple numerical bases");
-					if (stringvref != "0")
+					if (pos - start != 1 || text[start] != '0')
 						return tokenizer_error(lineno, "base notation starts with 0");
-					stringvref = "";
+					digits = pos + 1;
 					base = 8;
 				} else if ((c == 'b' || c == 'B') && base == 10) {
 					if (type == DOUBLE)
 						return tokenizer_error(lineno, "double can't be not decimal");
 					// if (base != 10)
 					//	return tokenizer_error(lineno, "integer can't have multiple numerical bases");
-					if (stringvref != "0")
+					if (pos - start != 1 || text[start] != '0')
 						return tokenizer_error(lineno, "base notation starts with 0");
-					stringvref = "";
+					digits = pos + 1;
 					base = 2;
 				} else if ((c == 'e' || c == 'E') && base != 16) {
 					if (base != 10)
@@ -443,24 +554,17 @@ int TokenStream::nextToken() {
 					type = DOUBLE;
 					// Start reading scientific notation
 					// double + E + (+ or -) + integer
-					stringvref += 'e';
 					c = next();
 					if ((c == '-' || c == '+')) {
 						// 12.34E26 is the same as 12.34E+26
-						stringvref += (wchar_t) c;
-						c = next();
-					}
-					string *integer = new string();
-					while (digit(c)) {
-						*integer += (wchar_t) c;
 						c = next();
 					}
-					if (*integer == "")
+					if (!digit(c))
 						return tokenizer_error(lineno, "expected exponent in scientific notation");
+					while (digit(c))
+						c = next();
 					if (alpha(c))
 						return tokenizer_error(lineno, "unexpected character in scientific notation");
-					stringvref += *integer;
-					delete integer;
 					scientific = true;
 					break;
 				} else if ((c == 'l' || c == 'L' || (c == 'b' || c == 'B') && base != 16) && !digit(c1)) {
@@ -468,16 +572,13 @@ int TokenStream::nextToken() {
 						type = LONG;
 					else
 						type = BYTE;
+					end = pos;
 					c = next();
 					break;
-				} else if (base == 16 && (('A' <= c && c <= 'F') || ('a' <= c && 'f' <= c) || digit(c)))
-					stringvref += (wchar_t) c;
-				else if (base == 8 && '0' <= c && c <= '7')
-					stringvref += (wchar_t) c;
-				else if (base == 2 && (c == '0' || c == '1'))
-					stringvref += (wchar_t) c;
-				else if (base == 10 && digit(c))
-					stringvref += (wchar_t) c;
+				} else if (base == 16 && hex(c) != -1);
+				else if (base == 8 && '0' <= c && c <= '7');
+				else if (base == 2 && (c == '0' || c == '1'));
+				else if (base == 10 && digit(c));
 				else if (alpha(c) || (base == 8 && '8' <= c && c <= '9')
 							      || (base == 2 && '3' <= c && c <= '9'))
 					return tokenizer_error(lineno, "unexpected character in number", c, "");
@@ -488,146 +589,115 @@ int TokenStream::nextToken() {
 				c1 = get(1);
 			}
 			
+			if (end < 0)
+				end = pos < length ? pos : length;
+			
 			if (type == DOUBLE) {
-				token->doublev = stringvref.toDouble(0);
+				token->doublev = decimal(text + start, end - start);
 				return put(DOUBLE);
 			}
 			if (type == INTEGER) {
-				token->integerv = (int) stringvref.toInt(base, 0);
+				token->integerv = (int) integer(text + digits, end - digits, base);
 				return put(INTEGER);
 			}
 			if (type == BYTE) {
-				token->longv = (unsigned char) stringvref.toInt(base, 0);
+				token->longv = (unsigned char) integer(text + digits, end - digits, base);
 				return put(BYTE);
 			}
 			if (type == LONG) {
-				token->longv =  (long) stringvref.toInt(base, 0);
+				token->longv =  (long) integer(text + digits, end - digits, base);
 				return put(LONG);
 			}
 		}
 	}
 	
 	/* D E L I M I T E R S */ {
-		// Parse delimiters
-		if (match('>', '>', '>', '='))
-			return put(ASSIGN_BITURSH);
-		if (match('>', '>', '>'))
-			return put(BITURSH);
-		if (match('>', '>', '='))
-			return put(ASSIGN_BITRSH);
-		if (match('<', '<', '='))
-			return put(ASSIGN_BITLSH);
-		if (match('>', '>'))
-			return put(BITRSH);
-		if (match('<', '<'))
-			return put(BITLSH);
-		if (match('>', '='))
-			return put(GE);
-		if (match('<', '='))
-			return put(LE);
-		if (match('&', '&'))
-			return put(AND);
-		if (match('|', '|'))
-			return put(OR);
-		if (match('=', '='))
-			return put(EQ);
-		if (match('!', '='))
-			return put(NEQ);
-		if (match('-', '>'))
-			return put(PUSH);
-		if (match('=', '>'))
-			return put(LAMBDA);
-		if (match('/', '/'))
-			return put(MDIV);
-		if (match('+', '+'))
-			return put(INC);
-		if (match('-', '-'))
-			return put(DEC);
-		if (match('+', '='))
-			return put(ASSIGN_ADD);
-		if (match('-', '='))
-			return put(ASSIGN_SUB);
-		if (match('*', '='))
-			return put(ASSIGN_MUL);
-		if (match('/', '='))
-			return put(ASSIGN_DIV);
-		if (match('%', '='))
-			return put(ASSIGN_MOD);
-		if (match('|', '='))
-			return put(ASSIGN_BITOR);
-		if (match('&', '='))
-			return put(ASSIGN_BITAND);
-		if (match('^', '='))
-			return put(ASSIGN_BITXOR);
-		if (match('~', '='))
-			return put(ASSIGN_BITNOT);
-		if (match('='))
-			return put(ASSIGN);
-		if (match('>'))
-			return put(GT);
-		if (match('<'))
-			return put(LT);
-		if (match('+'))
-			return put(PLUS);
-		if (match('-'))
-			return put(MINUS);
-		if (match('*'))
-			return put(MUL);
-		if (match('/'))
-			return put(DIV);
-		if (match('%'))
-			return put(MOD);
-		if (match('~'))
-			return put(BITNOT);
-		if (match('|'))
-			return put(BITOR);
-		if (match('&'))
-			return put(BITAND);
-		if (match('^'))
-			return put(BITXOR);
-		if (match('!'))
-			return put(NOT);
-		if (match('.'))
-			return put(DOT);
-		if (match('?'))
-			return put(HOOK);
-		if (match(':'))
-			return put(COLON);
-		if (match('\\'))
-			return put(PATH);
-		if (match('['))
-			return put(LB);
-		if (match(']'))
-			return put(RB);
-		if (match('{'))
-			return put(LC);
-		if (match('}'))
-			return put(RC);
-		if (match('('))
-			return put(LP);
-		if (match(')'))
-			return put(RP);
-		if (match(','))
-			return put(COMMA);
-		if (match(';'))
-			return put(SEMICOLON);
-		if (match('$'))
-			return put(SELF);
+		// Parse delimiters, longest first
+		switch (c) {
+			case '>':
+				if (c1 == '>') {
+					if (get(2) == '>')
+						return get(3) == '=' ? delimiter(4, ASSIGN_BITURSH) : delimiter(3, BITURSH);
+					return get(2) == '=' ? delimiter(3, ASSIGN_BITRSH) : delimiter(2, BITRSH);
+				}
+				return c1 == '=' ? delimiter(2, GE) : delimiter(1, GT);
+			
+			case '<':
+				if (c1 == '<')
+					return get(2) == '=' ? delimiter(3, ASSIGN_BITLSH) : delimiter(2, BITLSH);
+				return c1 == '=' ? delimiter(2, LE) : delimiter(1, LT);
+			
+			case '&':
+				if (c1 == '&') return delimiter(2, AND);
+				if (c1 == '=') return delimiter(2, ASSIGN_BITAND);
+				return delimiter(1, BITAND);
+			
+			case '|':
+				if (c1 == '|') return delimiter(2, OR);
+				if (c1 == '=') return delimiter(2, ASSIGN_BITOR);
+				return delimiter(1, BITOR);
+			
+			case '=':
+				if (c1 == '=') return delimiter(2, EQ);
+				if (c1 == '>') return delimiter(2, LAMBDA);
+				return delimiter(1, ASSIGN);
+			
+			case '-':
+				if (c1 == '>') return delimiter(2, PUSH);
+				if (c1 == '-') return delimiter(2, DEC);
+				if (c1 == '=') return delimiter(2, ASSIGN_SUB);
+				return delimiter(1, MINUS);
+			
+			case '+':
+				if (c1 == '+') return delimiter(2, INC);
+				if (c1 == '=') return delimiter(2, ASSIGN_ADD);
+				return delimiter(1, PLUS);
+			
+			case '/':
+				if (c1 == '/') return delimiter(2, MDIV);
+				if (c1 == '=') return delimiter(2, ASSIGN_DIV);
+				return delimiter(1, DIV);
+			
+			case '!': return c1 == '=' ? delimiter(2, NEQ)            : delimiter(1, NOT);
+			case '*': return c1 == '=' ? delimiter(2, ASSIGN_MUL)     : delimiter(1, MUL);
+			case '%': return c1 == '=' ? delimiter(2, ASSIGN_MOD)     : delimiter(1, MOD);
+			case '^': return c1 == '=' ? delimiter(2, ASSIGN_BITXOR)  : delimiter(1, BITXOR);
+			case '~': return c1 == '=' ? delimiter(2, ASSIGN_BITNOT)  : delimiter(1, BITNOT);
+			
+			case '.':  return delimiter(1, DOT);
+			case '?':  return delimiter(1, HOOK);
+			case ':':  return delimiter(1, COLON);
+			case '\\': return delimiter(1, PATH);
+			case '[':  return delimiter(1, LB);
+			case ']':  return delimiter(1, RB);
+			case '{':  return delimiter(1, LC);
+			case '}':  return delimiter(1, RC);
+			case '(':  return delimiter(1, LP);
+			case ')':  return delimiter(1, RP);
+			case ',':  return delimiter(1, COMMA);
+			case ';':  return delimiter(1, SEMICOLON);
+			case '$':  return delimiter(1, SELF);
+		}
 
 		if (c == '@' && alpha(c1)) {
 			// Read flag token
-			c = next();
-			while (alpha(c) || digit(c) || c == '_') {
-				token->stringv += (char) c;
-				c = next();
-			}
+			int end = pos + 1;
+			while (end < length && (alpha(text[end]) || digit(text[end])))
+				++end;
+			
+			token->text   = text + pos + 1;
+			token->length = end - pos - 1;
+			
+			pos = end - 1;
+			next();
 			return put(NAME);
 		}
 	}
 	
 	this->error_ = 1;
 	
-	printf("%c %c %c %c %c\n", c, get(-2), get(-1), get(0), get(1));
+	if (!silent_)
+		printf("%c %c %c %c %c\n", c, get(-2), get(-1), get(0), get(1));
 	
 	return tokenizer_error(lineno, "unexpected character", c, "");
 };
@@ -24,16 +24,26 @@
 
 #include "FakeStream.h"
 #include "RawToken.h"
+#include "Arena.h"
 
 struct TokenStream {
+	// Last read token
 	RawToken    *token;
+	// Tokens of the source, freed with the stream
+	Arena        arena;
 	
 	FAKESTREAM *source;
 	
-	int      buffer[9] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	// Decoded source text, scanned without copying
+	const wchar_t *text;
+	int          length;
+	// Index of the current char in text
+	int             pos;
 	
 	int           eof_ = 0;
 	int         error_ = 0;
+	// Set to 1 to suppress error messages (background parsing)
+	int        silent_ = 0;
 	
 	int lineno;
 	
@@ -51,13 +61,8 @@ struct TokenStream {
 	
 	int put(int token);
 	
-	int match(int charcode0);
-	
-	int match(int charcode0, int charcode1);
-	
-	int match(int charcode0, int charcode1, int charcode2);
-	
-	int match(int charcode0, int charcode1, int charcode2, int charcode3);
+	// Skips delimiter of given length and puts it's token
+	int delimiter(int length, int token);
 	
 	int eof();
 	
@@ -0,0 +1,265 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <time.h>
+#include <unistd.h>
+
+#include "Tracer.h"
+#include "ASTExecuter.h"
+#include "string.h"
+
+bool _tracer_enabled = 0;
+
+struct TracerEvent {
+	// B / E / X
+	char                       phase;
+	const char             *category;
+	unsigned long long            ts;
+	unsigned long long           dur;
+	char    name[TRACER_NAME_SIZE];
+	int                        nargs;
+	const char *argname[TRACER_MAX_ARGS];
+	long long   argvalue[TRACER_MAX_ARGS];
+};
+
+struct TracerRing {
+	TracerRing              *next;
+	int                       tid;
+	int                     count;
+	TracerEvent events[TRACER_RING_SIZE];
+};
+
+// Output & list of all rings are shared between threads
+static std::mutex   tracer_lock;
+static FILE        *tracer_out    = NULL;
+static TracerRing  *tracer_rings  = NULL;
+static int          tracer_tids   = 0;
+static int          tracer_pid    = 0;
+static bool         tracer_first  = 1;
+static unsigned long long tracer_origin = 0;
+
+static thread_local TracerRing *tracer_ring = NULL;
+
+unsigned long long tracer_now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+};
+
+static void tracer_json_string(const char *s) {
+	fputc('"', tracer_out);
+	for (; *s; ++s)
+		if (*s == '"' || *s == '\\')
+			fprintf(tracer_out, "\\%c", *s);
+		else if ((unsigned char) *s < 32)
+			fprintf(tracer_out, "\\u%04x", *s);
+		else
+			fputc(*s, tracer_out);
+	fputc('"', tracer_out);
+};
+
+// Formats events of the ring into output, called with tracer_lock held
+static void tracer_flush(TracerRing *ring) {
+	if (!tracer_out)
+		return;
+	
+	for (int i = 0; i < ring->count; ++i) {
+		TracerEvent *e = &ring->events[i];
+		
+		fprintf(tracer_out, "%s\n{\"ph\":\"%c\",\"cat\":\"%s\",\"name\":", tracer_first ? "" : ",", e->phase, e->category);
+		tracer_json_string(e->name);
+		fprintf(tracer_out, ",\"pid\":%d,\"tid\":%d,\"ts\":%.3f", tracer_pid, ring->tid, (e->ts - tracer_origin) / 1000.0);
+		
+		if (e->phase == 'X')
+			fprintf(tracer_out, ",\"dur\":%.3f", e->dur / 1000.0);
+		
+		if (e->nargs) {
+			fprintf(tracer_out, ",\"args\":{");
+			for (int j = 0; j < e->nargs; ++j)
+				fprintf(tracer_out, "%s\"%s\":%lld", j ? "," : "", e->argname[j], e->argvalue[j]);
+			fputc('}', tracer_out);
+		}
+		
+		fputc('}', tracer_out);
+		tracer_first = 0;
+	}
+	
+	ring->count = 0;
+};
+
+// Returns slot for the next event of the current thread
+static TracerEvent *tracer_event(char phase, const char *category) {
+	TracerRing *ring = tracer_ring;
+	
+	if (!ring) {
+		ring = tracer_ring = new TracerRing;
+		ring->count = 0;
+		
+		std::lock_guard<std::mutex> guard(tracer_lock);
+		ring->tid    = ++tracer_tids;
+		ring->next   = tracer_rings;
+		tracer_rings = ring;
+	} else if (ring->count == TRACER_RING_SIZE) {
+		std::lock_guard<std::mutex> guard(tracer_lock);
+		tracer_flush(ring);
+	}
+	
+	TracerEvent *e = &ring->events[ring->count++];
+	e->phase    = phase;
+	e->category = category;
+	e->ts       = tracer_now();
+	e->nargs    = 0;
+	e->name[0]  = 0;
+	return e;
+};
+
+static void tracer_name(TracerEvent *e, const char *name) {
+	int length = strlen(name);
+	
+	// Keep the tail, file names differ at the end
+	if (length >= TRACER_NAME_SIZE)
+		name += length - TRACER_NAME_SIZE + 1;
+	
+	strncpy(e->name, name, TRACER_NAME_SIZE - 1);
+	e->name[TRACER_NAME_SIZE - 1] = 0;
+};
+
+static void tracer_name(TracerEvent *e, string *name) {
+	int offset = name->length >= TRACER_NAME_SIZE ? name->length - TRACER_NAME_SIZE + 1 : 0;
+	int i      = 0;
+	
+	for (; offset + i < name->length; ++i) {
+		wchar_t c  = name->buffer[offset + i];
+		e->name[i] = c < 128 ? (char) c : '?';
+	}
+	e->name[i] = 0;
+};
+
+bool tracer_start(const char *path) {
+	tracer_out = fopen(path, "w");
+	if (!tracer_out) {
+		fprintf(stderr, "Tracer: can not write %s\n", path);
+		return 0;
+	}
+	
+	tracer_pid     = getpid();
+	tracer_origin  = tracer_now();
+	tracer_first   = 1;
+	_tracer_enabled = 1;
+	
+	fprintf(tracer_out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	return 1;
+};
+
+void tracer_stop() {
+	if (!_tracer_enabled)
+		return;
+	_tracer_enabled = 0;
+	
+	std::lock_guard<std::mutex> guard(tracer_lock);
+	
+	// Thread names, so viewer shows interpreter thread
+	for (TracerRing *ring = tracer_rings; ring; ring = ring->next) {
+		tracer_flush(ring);
+		fprintf(tracer_out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			tracer_first ? "" : ",", tracer_pid, ring->tid, ring->tid == 1 ? "ck" : "ck worker");
+		tracer_first = 0;
+	}
+	
+	fprintf(tracer_out, "\n]}\n");
+	fclose(tracer_out);
+	tracer_out = NULL;
+	
+	// Rings of other threads are owned by them
+	while (tracer_rings) {
+		TracerRing *ring = tracer_rings->next;
+		if (tracer_rings == tracer_ring) {
+			delete tracer_ring;
+			tracer_ring = NULL;
+		} else
+			tracer_rings->count = 0;
+		tracer_rings = ring;
+	}
+	tracer_tids = 0;
+};
+
+void tracer_enter(ASTExecuter *executer, int level, bool native) {
+	TracerEvent *e = tracer_event('B', TRACER_FUNCTION);
+	
+	ASTExecuterStackTraceElement *trace = executer->aststacktrace->head;
+	if (trace && trace->level != level)
+		trace = NULL;
+	
+	if (native && trace && trace->type != ASTESTE_NAME && trace->next
+		&& trace->next->level == level - 1 && trace->next->type == ASTESTE_NAME)
+		trace = trace->next;
+	
+	if (trace) {
+		if (trace->type == ASTESTE_NAME)
+			tracer_name(e, &trace->tracename);
+		else
+			tracer_name(e, "<anonymous>");
+		
+		e->nargs       = 1;
+		e->argname[0]  = "line";
+		e->argvalue[0] = trace->tracelineno;
+	} else
+		tracer_name(e, "<anonymous>");
+};
+
+void tracer_begin(const char *category, const char *name) {
+	tracer_name(tracer_event('B', category), name);
+};
+
+void tracer_begin(const char *category, string *name) {
+	tracer_name(tracer_event('B', category), name);
+};
+
+void tracer_end(const char *category) {
+	tracer_event('E', category);
+};
+
+void tracer_complete(const char *category, const char *name, unsigned long long start,
+                     const char *arg0, long long value0,
+                     const char *arg1, long long value1) {
+	TracerEvent *e = tracer_event('X', category);
+	tracer_name(e, name);
+	
+	e->dur = e->ts - start;
+	e->ts  = start;
+	
+	if (arg0) {
+		e->argname[e->nargs]    = arg0;
+		e->argvalue[e->nargs++] = value0;
+	}
+	if (arg1) {
+		e->argname[e->nargs]    = arg1;
+		e->argvalue[e->nargs++] = value1;
+	}
+};
+
+void tracer_complete(const char *category, string *name, unsigned long long start) {
+	TracerEvent *e = tracer_event('X', category);
+	tracer_name(e, name);
+	
+	e->dur = e->ts - start;
+	e->ts  = start;
+};
@@ -0,0 +1,80 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Trace Event Format writer (ck --trace=out.json).
+ * Events are recorded into fixed-size per-thread rings and formatted
+ * only when ring is full or tracing is stopped, so hot paths
+ * (function calls, GC pauses) only copy a few fields.
+ * Output can be opened in chrome://tracing or Perfetto.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <cstddef>
+
+// Amount of events in single per-thread ring
+#define TRACER_RING_SIZE 8192
+// Max length of event name, longer names keep the tail
+#define TRACER_NAME_SIZE 64
+// Max amount of integer arguments of event
+#define TRACER_MAX_ARGS  2
+
+// Categories of events
+#define TRACER_FUNCTION "function"
+#define TRACER_IMPORT   "import"
+#define TRACER_PARSE    "parse"
+#define TRACER_NATIVE   "native"
+#define TRACER_GC       "gc"
+#define TRACER_STARTUP  "startup"
+
+struct ASTExecuter;
+struct string;
+
+// 1 if trace is being written
+extern bool _tracer_enabled;
+
+// Opens output file, returns 0 on failure
+bool tracer_start(const char *path);
+
+// Flushes all rings & closes output file
+void tracer_stop();
+
+// Monotonic time in nanoseconds, used as start of complete events
+unsigned long long tracer_now();
+
+// Begin event of script function called on given level.
+// Name is taken from stack trace record of the call,
+// native calls (operators, callbacks) may be named by the caller
+// one level above.
+void tracer_enter(ASTExecuter *executer, int level, bool native = 0);
+
+// Begin event with the given name
+void tracer_begin(const char *category, const char *name);
+void tracer_begin(const char *category, string *name);
+
+// End of the last begin event
+void tracer_end(const char *category);
+
+// Complete event from start till now with up to TRACER_MAX_ARGS integer arguments
+void tracer_complete(const char *category, const char *name, unsigned long long start,
+                     const char *arg0 = NULL, long long value0 = 0,
+                     const char *arg1 = NULL, long long value1 = 0);
+void tracer_complete(const char *category, string *name, unsigned long long start);
+
+#endif
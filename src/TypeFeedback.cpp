@@ -0,0 +1,228 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <cwchar>
+
+#include "TypeFeedback.h"
+#include "ASTExecuter.h"
+#include "TokenNamespace.h"
+
+const char *tokenToString(int token);
+
+bool _type_feedback_enabled = 0;
+
+// Interned file name
+struct TypeFeedbackFile {
+	TypeFeedbackFile *next;
+	unsigned int      hash;
+	string            path;
+	char             *name;
+};
+
+static TypeFeedbackSite *feedback_sites[TYPE_FEEDBACK_TABLE_SIZE];
+static int               feedback_sites_count = 0;
+static TypeFeedbackFile *feedback_files       = NULL;
+
+static const char *internFile(string *path) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < path->length; ++i) {
+		h ^= (unsigned int) path->buffer[i];
+		h *= 16777619u;
+	}
+	
+	for (TypeFeedbackFile *f = feedback_files; f; f = f->next)
+		if (f->hash == h && f->path.length == path->length && !wmemcmp(f->path.buffer, path->buffer, path->length))
+			return f->name;
+	
+	TypeFeedbackFile *f = new TypeFeedbackFile;
+	f->hash             = h;
+	f->path             = *path;
+	f->name             = path->toCString();
+	f->next             = feedback_files;
+	feedback_files      = f;
+	return f->name;
+};
+
+// File of the code executed by executer
+static const char *currentFile(ASTExecuter *executer) {
+	ASTExecuterStackTraceElement *t = executer->aststacktrace->head;
+	for (int i = 0; t && i < executer->aststacktrace->pos_size; ++i, t = t->next)
+		if (t->type == ASTESTE_FILE)
+			return internFile(&t->tracename);
+	
+	return "<native>";
+};
+
+static TypeFeedbackSite *site(ASTExecuter *executer, ASTNode *node) {
+	unsigned int h = ((unsigned long) node >> 4) % TYPE_FEEDBACK_TABLE_SIZE;
+	
+	// Node may be reused after the tree is disposed, compare type & line too
+	for (TypeFeedbackSite *s = feedback_sites[h]; s; s = s->next)
+		if (s->node == node && s->node_type == node->type && s->lineno == node->lineno)
+			return s;
+	
+	TypeFeedbackSite *s = (TypeFeedbackSite*) calloc(1, sizeof(TypeFeedbackSite));
+	s->node             = node;
+	s->node_type        = node->type;
+	s->lineno           = node->lineno;
+	s->file             = currentFile(executer);
+	s->next             = feedback_sites[h];
+	feedback_sites[h]   = s;
+	++feedback_sites_count;
+	return s;
+};
+
+static int typeTag(VirtualObject *o) {
+	return o ? o->type : TYPE_FEEDBACK_NONE;
+};
+
+void type_feedback_start() {
+	_type_feedback_enabled = 1;
+};
+
+void type_feedback_record(ASTExecuter *executer, ASTNode *node, VirtualObject *left, VirtualObject *right) {
+	if (!node)
+		return;
+	
+	TypeFeedbackSite *s = site(executer, node);
+	int l               = typeTag(left);
+	int r               = typeTag(right);
+	
+	++s->hits;
+	
+	for (int i = 0; i < s->count; ++i)
+		if (s->shapes[i].left == l && s->shapes[i].right == r) {
+			++s->shapes[i].hits;
+			return;
+		}
+	
+	if (s->count < TYPE_FEEDBACK_SHAPES) {
+		s->shapes[s->count].left  = l;
+		s->shapes[s->count].right = r;
+		s->shapes[s->count].hits  = 1;
+		++s->count;
+	} else
+		++s->megamorphic;
+};
+
+// Name of type tag
+static const char *typeName(int type, char *buffer, int size) {
+	if (type == TYPE_FEEDBACK_NONE)
+		return "-";
+	return typeToString(type, buffer, size);
+};
+
+// Name of node type
+static const char *nodeName(int type) {
+	const char *name = tokenToString(type);
+	return name && *name ? name : "?";
+};
+
+static int compareSites(const void *a, const void *b) {
+	TypeFeedbackSite *x = *(TypeFeedbackSite**) a;
+	TypeFeedbackSite *y = *(TypeFeedbackSite**) b;
+	
+	if (x->hits != y->hits)
+		return x->hits < y->hits ? 1 : -1;
+	return 0;
+};
+
+// Prints sites of one kind, returns amount of them
+static int printSites(FILE *out, TypeFeedbackSite **sites, const char *title, int min_shapes, int max_shapes, bool megamorphic) {
+	char buffer[32];
+	char location[256];
+	
+	int total = 0;
+	for (int i = 0; i < feedback_sites_count; ++i)
+		if (!!sites[i]->megamorphic == megamorphic && sites[i]->count >= min_shapes && sites[i]->count <= max_shapes)
+			++total;
+	
+	fprintf(out, "\n%s: %d\n", title, total);
+	if (!total)
+		return 0;
+	
+	fprintf(out, "%12s  %-32s %-10s  %s\n", "hits", "site", "node", "shapes");
+	
+	int printed = 0;
+	for (int i = 0; i < feedback_sites_count && printed < TYPE_FEEDBACK_TOP; ++i) {
+		TypeFeedbackSite *s = sites[i];
+		if (!!s->megamorphic != megamorphic || s->count < min_shapes || s->count > max_shapes)
+			continue;
+		++printed;
+		
+		snprintf(location, sizeof(location), "%s:%d", s->file, s->lineno);
+		fprintf(out, "%12lld  %-32s %-10s ", s->hits, location, nodeName(s->node_type));
+		
+		for (int j = 0; j < s->count; ++j) {
+			fprintf(out, " %s", typeName(s->shapes[j].left, buffer, sizeof(buffer)));
+			if (s->shapes[j].right != TYPE_FEEDBACK_NONE)
+				fprintf(out, ",%s", typeName(s->shapes[j].right, buffer, sizeof(buffer)));
+			fprintf(out, " %.1f%%", 100.0 * s->shapes[j].hits / s->hits);
+		}
+		
+		if (s->megamorphic)
+			fprintf(out, " <other> %.1f%%", 100.0 * s->megamorphic / s->hits);
+		
+		fputc('\n', out);
+	}
+	
+	return total;
+};
+
+void type_feedback_stop() {
+	if (!_type_feedback_enabled)
+		return;
+	_type_feedback_enabled = 0;
+	
+	TypeFeedbackSite **sites = (TypeFeedbackSite**) malloc((feedback_sites_count + 1) * sizeof(TypeFeedbackSite*));
+	int count = 0;
+	for (int i = 0; i < TYPE_FEEDBACK_TABLE_SIZE; ++i)
+		for (TypeFeedbackSite *s = feedback_sites[i]; s; s = s->next)
+			sites[count++] = s;
+	
+	qsort(sites, count, sizeof(TypeFeedbackSite*), compareSites);
+	
+	long long hits = 0;
+	for (int i = 0; i < count; ++i)
+		hits += sites[i]->hits;
+	
+	fprintf(stderr, "\nType feedback: %d sites, %lld hits\n", count, hits);
+	printSites(stderr, sites, "Monomorphic",  1, 1,                    0);
+	printSites(stderr, sites, "Polymorphic",  2, TYPE_FEEDBACK_SHAPES, 0);
+	printSites(stderr, sites, "Megamorphic",  1, TYPE_FEEDBACK_SHAPES, 1);
+	
+	free(sites);
+	
+	// Dispose tables
+	for (int i = 0; i < TYPE_FEEDBACK_TABLE_SIZE; ++i)
+		while (feedback_sites[i]) {
+			TypeFeedbackSite *s = feedback_sites[i]->next;
+			free(feedback_sites[i]);
+			feedback_sites[i] = s;
+		}
+	feedback_sites_count = 0;
+	
+	while (feedback_files) {
+		TypeFeedbackFile *f = feedback_files->next;
+		free(feedback_files->name);
+		delete feedback_files;
+		feedback_files = f;
+	}
+};
@@ -0,0 +1,82 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Type feedback collector (ck --dump-type-feedback).
+ * Executer records type tags (VirtualObject::type) of operands of
+ * operators, receivers & keys of MEMBER / FIELD and receivers &
+ * callees of CALL in small per-node profile. Site with one observed
+ * shape is monomorphic, up to TYPE_FEEDBACK_SHAPES is polymorphic,
+ * megamorphic after that. Report is printed on exit.
+ */
+
+#ifndef TYPE_FEEDBACK_H
+#define TYPE_FEEDBACK_H
+
+// Amount of shapes kept per node before it becomes megamorphic
+#define TYPE_FEEDBACK_SHAPES     4
+// Amount of buckets in site table
+#define TYPE_FEEDBACK_TABLE_SIZE 4096
+// Amount of sites printed in each table of report
+#define TYPE_FEEDBACK_TOP        20
+// Tag of missing operand / receiver
+#define TYPE_FEEDBACK_NONE       -1
+
+struct ASTNode;
+struct ASTExecuter;
+struct VirtualObject;
+
+// Pair of observed type tags
+struct TypeFeedbackShape {
+	int        left;
+	int        right;
+	long long  hits;
+};
+
+struct TypeFeedbackSite {
+	TypeFeedbackSite *next;
+	ASTNode          *node;
+	// Node type & line are copied, tree may be disposed before report
+	int          node_type;
+	int          lineno;
+	// Interned file name
+	const char  *file;
+	
+	long long    hits;
+	int          count;
+	TypeFeedbackShape shapes[TYPE_FEEDBACK_SHAPES];
+	// Hits of shapes that did not fit into profile
+	long long    megamorphic;
+};
+
+// 1 if executer records type feedback
+extern bool _type_feedback_enabled;
+
+// Starts recording
+void type_feedback_start();
+
+// Records shape observed on the node
+void type_feedback_record(ASTExecuter *executer, ASTNode *node, VirtualObject *left, VirtualObject *right);
+
+// Prints report to stderr & disposes profiles
+void type_feedback_stop();
+
+#define TYPE_FEEDBACK(node, left, right) \
+	if (_type_feedback_enabled) \
+		type_feedback_record(this, node, left, right);
+
+#endif
@@ -45,6 +45,14 @@
 #include "ASTNode.h"
 #include "Parser.h"
 #include "ASTPrinter.h"
+#include "ASTOptimizer.h"
+#include "ASTCache.h"
+#include "ImportPrefetch.h"
+#include "Profiler.h"
+#include "ASTCounters.h"
+#include "Tracer.h"
+#include "AllocProfiler.h"
+#include "TypeFeedback.h"
 #include "ColoredOutput.h"
 #include "GarbageCollector.h"
 #include "ASTExecuter.h"
@@ -66,6 +74,28 @@ FAKESTREAM    *instream = NULL;
 ASTExecuter   *executer = NULL;
 Context *global_context = NULL;
 
+// Output of --profile, NULL if disabled
+const char  *profile_path = NULL;
+// Output of --trace, NULL if disabled
+const char    *trace_path = NULL;
+// Set by --alloc-profile
+bool    alloc_profile = 0;
+// Set by --dump-type-feedback
+bool    type_feedback = 0;
+// Output of --gc-stats, NULL if disabled
+const char *gc_stats_path = NULL;
+
+
+// Returns value of option in form --name=value / NULL
+const char *optionValue(const char *arg, const char *name) {
+	int i = 0;
+	while (name[i]) {
+		if (arg[i] != name[i])
+			return NULL;
+		++i;
+	}
+	return arg[i] == '=' ? arg + i + 1 : NULL;
+};
 
 // Handler for system signals
 void signal_callback_handler(int signum) {
@@ -76,17 +106,28 @@ void signal_callback_handler(int signum) {
 // 3 in 1. Only for 0.95$ now!
 // Passing raw arguments with offset
 void compactMain(const char *path, int argc, char **argv) {		
-	tstream = new TokenStream;
-	parser  = new Parser;
+	if (trace_path)
+		tracer_start(trace_path);
 	
-	tstream->init(instream);
-	parser->init(tstream);
+	unsigned long long parse_start = _tracer_enabled ? tracer_now() : 0;
 	
-	// Parse code
-	root = parser->parse(); // <- BUG
+	// Precompiled tree of the file, already folded
+	bool cached = 0;
+	if (_ast_cache_dir && path != "/") {
+		root   = ast_cache_load(path, instream->string, instream->length);
+		cached = root != NULL;
+	}
 	
-	delete instream;
-	instream = NULL;
+	if (!cached) {
+		tstream = new TokenStream;
+		parser  = new Parser;
+		
+		tstream->init(instream);
+		parser->init(tstream);
+		
+		// Parse code
+		root = parser->parse(); // <- BUG
+	}
 	
 	cgreen;
 	DEBUG("DELETE PARSER")
@@ -97,8 +138,26 @@ void compactMain(const char *path, int argc, char **argv) {
 	tstream = NULL;
 	cwhite;
 
-	if (!root || _global_int_state)
+	if (!root || _global_int_state) {
+		delete instream;
+		instream = NULL;
+		tracer_stop();
 		return 0;
+	}
+	
+	if (!cached) {
+		// Fold constant expressions
+		optimizeAST(root);
+		
+		if (_ast_cache_dir && path != "/")
+			ast_cache_store(path, instream->string, instream->length, root);
+	}
+	
+	delete instream;
+	instream = NULL;
+	
+	if (_tracer_enabled)
+		tracer_complete(TRACER_PARSE, path, parse_start);
 	
 	// Print source if needed
 #ifdef PRINT_CODE_ENABLED
@@ -107,12 +166,17 @@ void compactMain(const char *path, int argc, char **argv) {
 #endif	
 
 	// Define global context & variables & other stuff
+	unsigned long long define_start = _tracer_enabled ? tracer_now() : 0;
+	
 	global_context                 = new Context();
 	global_context->scope          = new Scope(NULL);
 	global_context->scope->context = global_context;
 	GC.gc_attach_root(global_context->scope);
 	defineTypes(global_context->scope);
 	
+	if (_tracer_enabled)
+		tracer_complete(TRACER_STARTUP, "defineTypes", define_start, "objects", GC.gc_size);
+	
 	global_context->script_file_path = FileUrl::getRealPath(path == "/" ? "virtual" : path);
 	global_context->script_dir_path  = path == "/" ? path : global_context->script_file_path->getDirectory();
 	
@@ -124,10 +188,44 @@ void compactMain(const char *path, int argc, char **argv) {
 	global_context->scope->table->put(string("arguments"), arguments_array);
 	*/
 	
+	// Parse imported files while script starts
+	if (_import_prefetch_threads && path != "/")
+		import_prefetch_start(root, global_context->script_dir_path->path);
+	
 	// Create executer & run code
 	executer = new ASTExecuter;
+	
+	if (profile_path)
+		profiler_start(profile_path);
+	
+	if (alloc_profile)
+		alloc_profiler_start(executer);
+	
+	if (type_feedback)
+		type_feedback_start();
+	
 	executer->begin(global_context, root);
 	
+	import_prefetch_stop();
+	
+	if (profile_path)
+		profiler_stop();
+	
+	alloc_profiler_stop();
+	
+	type_feedback_stop();
+	
+	AST_COUNTERS_DUMP()
+	
+	if (gc_stats_path) {
+		FILE *out = fopen(gc_stats_path, "w");
+		if (out) {
+			GC.gc_write_stats(out);
+			fclose(out);
+		} else
+			fprintf(stderr, "Can not write %s\n", gc_stats_path);
+	}
+	
 	// Collect garbage
 	GC.gc_deattach_root(global_context->scope);
 	
@@ -148,6 +246,11 @@ void compactMain(const char *path, int argc, char **argv) {
 	
 	// Unload loaded modules to free memory.
 	unload_loaded_modules();
+	
+	// Trees of imported files may be referenced by functions till the end
+	dispose_imported_scripts();
+	
+	tracer_stop();
 };
 
 int main(int argc, char **argv) {
@@ -157,6 +260,40 @@ int main(int argc, char **argv) {
 	signal(SIGINT,  signal_callback_handler);
 	signal(SIGTERM, signal_callback_handler);
 	
+	// Parse interpreter options preceding execution mode
+	int optc = 1;
+	while (optc < argc && argv[optc][0] == '-' && argv[optc][1] == '-') {
+		if (strcmp(argv[optc], "--no-fold"))
+			_ast_fold_enabled = 0;
+		else if (strcmp(argv[optc], "--profile"))
+			profile_path = PROFILER_DEFAULT_OUTPUT;
+		else if (optionValue(argv[optc], "--profile"))
+			profile_path = optionValue(argv[optc], "--profile");
+		else if (strcmp(argv[optc], "--alloc-profile"))
+			alloc_profile = 1;
+		else if (strcmp(argv[optc], "--dump-type-feedback"))
+			type_feedback = 1;
+		else if (optionValue(argv[optc], "--gc-stats"))
+			gc_stats_path = optionValue(argv[optc], "--gc-stats");
+		else if (strcmp(argv[optc], "--cache"))
+			_ast_cache_dir = ast_cache_default_dir();
+		else if (optionValue(argv[optc], "--cache"))
+			_ast_cache_dir = optionValue(argv[optc], "--cache");
+		else if (strcmp(argv[optc], "--prefetch-imports"))
+			_import_prefetch_threads = import_prefetch_default_threads();
+		else if (optionValue(argv[optc], "--prefetch-imports"))
+			_import_prefetch_threads = atoi(optionValue(argv[optc], "--prefetch-imports"));
+		else if (optionValue(argv[optc], "--trace"))
+			trace_path = optionValue(argv[optc], "--trace");
+		else {
+			printf("Unknown option %s.\nUse -h for help.\n", argv[optc]);
+			return 0;
+		}
+		++optc;
+	}
+	argc -= optc - 1;
+	argv += optc - 1;
+	
 	if (argc == 1) {
 		printf("Empty args.\nUse -h for help.\n");
 		return 0;
@@ -197,6 +334,22 @@ int main(int argc, char **argv) {
 		printf(":: -s <file path>: execute script from command line arguments.\n");
 		printf(":: -i <file path>: execute script from STDIN.\n");
 		printf(":: <file path>:    execute script from file.\n");
+		printf("Options (placed before mode):\n");
+		printf(":: --no-fold:      disable constant folding of parsed code.\n");
+		printf(":: --cache{=<dir>}: keep parsed trees of scripts & imported files\n");
+		printf("                   in directory (~/%s), skip parsing if unchanged.\n", AST_CACHE_DEFAULT_DIR);
+		printf(":: --prefetch-imports{=<threads>}: parse files imported with literal path\n");
+		printf("                   on threads (one per CPU) before they are reached.\n");
+		printf(":: --profile{=<file>}: sample script stacks, write collapsed stacks\n");
+		printf("                   to file (%s) and print hot lines.\n", PROFILER_DEFAULT_OUTPUT);
+		printf(":: --trace=<file>: write function calls, imports & GC pauses\n");
+		printf("                   in Trace Event Format (chrome://tracing).\n");
+		printf(":: --alloc-profile: tag objects with allocating line, print sites,\n");
+		printf("                   types & retainers on exit (GC.allocationProfile()).\n");
+		printf(":: --gc-stats=<file>: write GC pause & throughput counters as JSON\n");
+		printf("                   on exit (GC.stats()).\n");
+		printf(":: --dump-type-feedback: print operand, receiver & callee types seen\n");
+		printf("                   by operators, member access & calls on exit.\n");
 	} else
 		if (argc >= 2) {
 			cbegin;
@@ -32,18 +32,24 @@
 
 ArrayPrototype *array_prototype = NULL;
 
+static void define_array_prototype(Object *proto);
+
 // Array type
 Array::Array() {
 	array = new VectorArray<VirtualObject>;
-	if (array_prototype)
+	if (array_prototype) {
+		array_prototype->define();
 		table->putAll(array_prototype->table);
+	}
 	type = ARRAY;
 };
 
 Array::Array(VectorArray<VirtualObject> *array) {
 	this->array = array;
-	if (array_prototype)
+	if (array_prototype) {
+		array_prototype->define();
 		table->putAll(array_prototype->table);
+	}
 	type = ARRAY;
 };
 
@@ -116,6 +122,14 @@ void Array::mark(void) {
 				array->vector[i]->mark();
 };
 
+void Array::references(GC_Visitor *visitor) {
+	Object::references(visitor);
+	
+	if (array)
+		for (int i = 0; i < array->length; ++i)
+			visitor->visit(array->vector[i]);
+};
+
 void Array::push(VirtualObject *o) {
 	array->push(o);
 };
@@ -150,7 +164,7 @@ double Array::toDouble() {
 
 
 // Array prototype	
-ArrayPrototype::ArrayPrototype() {	
+ArrayPrototype::ArrayPrototype() : LazyObject(&define_array_prototype) {	
 	type = ARRAY_PROTOTYPE;
 };
 
@@ -159,18 +173,22 @@ void ArrayPrototype::finalize(void) {
 };
 
 VirtualObject *ArrayPrototype::get(Scope *scope, string *name) {
+	define();
 	return table->get(*name);
 };
 
 void ArrayPrototype::put(Scope *scope, string *name, VirtualObject *value) {
+	define();
 	table->put(*name, value);
 }; 
 
 void ArrayPrototype::remove(Scope *scope, string *name) {
+	define();
 	table->remove(*name);
 };
 
 bool ArrayPrototype::contains(Scope *scope, string *name) {
+	define();
 	return table->contains(*name);
 };
 
@@ -347,17 +365,20 @@ static VirtualObject* function_size(Scope *scope, int argc, VirtualObject **args
 	return new Integer(((Array*) o)->array->length);
 };
 
+// Defines methods of array prototype on the first use
+static void define_array_prototype(Object *proto) {
+	proto->table->put(string("__typename"),   new String("Array"));
+	proto->table->put(string("__operator=="), new NativeFunction(&operator_eq));
+	proto->table->put(string("__operator!="), new NativeFunction(&operator_eq));
+	proto->table->put(string("__operator+"),  new NativeFunction(&operator_add));
+	proto->table->put(string("push"),         new NativeFunction(&function_push));	
+	proto->table->put(string("pop"),          new NativeFunction(&function_push));	
+	proto->table->put(string("size"),         new NativeFunction(&function_size));	
+};
+
 // Called on start. Defines array prototype & type
 void define_array(Scope *scope) {
 	array_prototype = new ArrayPrototype();
 	scope->table->put(string("Array"), array_prototype);
-	
-	array_prototype->table->put(string("__typename"),   new String("Array"));
-	array_prototype->table->put(string("__operator=="), new NativeFunction(&operator_eq));
-	array_prototype->table->put(string("__operator!="), new NativeFunction(&operator_eq));
-	array_prototype->table->put(string("__operator+"),  new NativeFunction(&operator_add));
-	array_prototype->table->put(string("push"),         new NativeFunction(&function_push));	
-	array_prototype->table->put(string("pop"),          new NativeFunction(&function_push));	
-	array_prototype->table->put(string("size"),         new NativeFunction(&function_size));	
 };
 
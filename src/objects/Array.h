@@ -29,8 +29,9 @@
 #include "../VectorArray.h"
 #include "../string.h"
 
-// Object prototype's prototype	
-struct ArrayPrototype : Object {
+// Array prototype's prototype.
+// Methods are defined on the first use.
+struct ArrayPrototype : LazyObject {
 	ArrayPrototype();
 	void finalize(void);
 	VirtualObject *get(Scope*, string*);
@@ -53,6 +54,7 @@ struct Array : Object, IntCastObject, StringCastObject, DoubleCastObject {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 	
 	void push(VirtualObject*);
 	
@@ -0,0 +1,88 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "BuiltinTable.h"
+
+BuiltinTable::BuiltinTable(const BuiltinMethod *methods, unsigned int seed) {
+	this->methods = methods;
+	this->seed    = seed;
+	for (int i = 0; i < BUILTIN_SLOTS; ++i) {
+		functions[i]  = NULL;
+		overridden[i] = 0;
+	}
+};
+
+int BuiltinTable::find(string *name) {
+	// Same as builtin_fnv
+	unsigned int h = seed;
+	for (int i = 0; i < name->length; ++i)
+		h = (h ^ (unsigned int) name->buffer[i]) * 16777619u;
+	
+	int slot = builtin_index(h);
+	
+	const char *s = methods[slot].name;
+	if (!s)
+		return -1;
+	
+	int i = 0;
+	for (; i < name->length; ++i)
+		if (!s[i] || name->buffer[i] != s[i])
+			return -1;
+	
+	return s[i] ? -1 : slot;
+};
+
+VirtualObject *BuiltinTable::get(string *name) {
+	int slot = find(name);
+	if (slot == -1 || overridden[slot])
+		return NULL;
+	
+	if (!functions[slot])
+		functions[slot] = new NativeFunction(methods[slot].handler);
+	
+	return functions[slot];
+};
+
+void BuiltinTable::override(string *name) {
+	int slot = find(name);
+	if (slot != -1)
+		overridden[slot] = 1;
+};
+
+void BuiltinTable::define(TreeObjectMap *table) {
+	for (int i = 0; i < BUILTIN_SLOTS; ++i) {
+		if (!methods[i].name || overridden[i])
+			continue;
+		
+		if (!functions[i])
+			functions[i] = new NativeFunction(methods[i].handler);
+		
+		table->put(string(methods[i].name), functions[i]);
+	}
+};
+
+void BuiltinTable::mark() {
+	for (int i = 0; i < BUILTIN_SLOTS; ++i)
+		if (functions[i] && !functions[i]->gc_reachable && !functions[i]->gc_root)
+			functions[i]->mark();
+};
+
+void BuiltinTable::references(GC_Visitor *visitor) {
+	for (int i = 0; i < BUILTIN_SLOTS; ++i)
+		visitor->visit(functions[i]);
+};
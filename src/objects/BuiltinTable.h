@@ -0,0 +1,96 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Compile-time method tables of builtin prototypes.
+ * Fixed methods are placed by perfect hash of the name, so
+ * lookup is single hash & compare instead of TreeObjectMap search.
+ * Table is consulted before dynamic table of the prototype,
+ * methods written or removed through the prototype are
+ * looked up in the dynamic table.
+ */
+
+#ifndef BUILTIN_TABLE_H
+#define BUILTIN_TABLE_H
+
+#include "NativeFunction.h"
+#include "TreeObjectMap.h"
+
+#include "../string.h"
+
+// Amount of slots in method table, power of 2
+#define BUILTIN_SLOTS 64
+#define BUILTIN_NONE  { NULL, NULL }
+
+struct BuiltinMethod {
+	const char       *name;
+	handler_function handler;
+};
+
+// FNV-1a of the name, seed is picked for each table
+static constexpr unsigned int builtin_fnv(const char *name, unsigned int h) {
+	return *name ? builtin_fnv(name + 1, (h ^ (unsigned char) *name) * 16777619u) : h;
+};
+
+static constexpr unsigned int builtin_mix(unsigned int h) {
+	return h ^ (h >> 13);
+};
+
+// Slot of the hash after final mix, low bits depend on all chars
+static constexpr int builtin_index(unsigned int h) {
+	return builtin_mix((h ^ (h >> 16)) * 0x85ebca6bu) & (BUILTIN_SLOTS - 1);
+};
+
+static constexpr int builtin_slot(const char *name, unsigned int seed) {
+	return builtin_index(builtin_fnv(name, seed));
+};
+
+// Checks that every method is placed in it's slot
+static constexpr bool builtin_table_valid(const BuiltinMethod *methods, unsigned int seed, int i = 0) {
+	return i == BUILTIN_SLOTS
+		|| ((!methods[i].name || builtin_slot(methods[i].name, seed) == i)
+			&& builtin_table_valid(methods, seed, i + 1));
+};
+
+struct BuiltinTable {
+	const BuiltinMethod *methods;
+	unsigned int            seed;
+	// Function objects of slots, created on the first use
+	NativeFunction    *functions[BUILTIN_SLOTS];
+	// Slots written or removed through the prototype
+	bool              overridden[BUILTIN_SLOTS];
+	
+	BuiltinTable(const BuiltinMethod *methods, unsigned int seed);
+	
+	// Slot of the method or -1
+	int find(string *name);
+	
+	// Builtin method or NULL if there is no such method or it is overridden
+	VirtualObject *get(string *name);
+	
+	// Dynamic table is used for the method since now
+	void override(string *name);
+	
+	// Puts all methods into the table
+	void define(TreeObjectMap *table);
+	
+	void mark();
+	
+	void references(GC_Visitor *visitor);
+};
+
+#endif
@@ -66,7 +66,8 @@ bool CodeFunction::contains(Scope *scope, string *name) {
 	return table->contains(*name);
 };
 
-// Apply arguments on the given scope & assign parent of this scope
+// Apply arguments on the given scope & assign parent of this scope.
+// Executer passes arguments through CallScope instead.
 VirtualObject *CodeFunction::call(Scope *scope, int argc, VirtualObject **args) {
 	// scope->parent = this->scope;
 	ASTObjectList *l = this->node->objectlist;
@@ -77,6 +78,8 @@ VirtualObject *CodeFunction::call(Scope *scope, int argc, VirtualObject **args)
 		} else
 			break;
 	};
+	
+	return NULL;
 };
 
 void CodeFunction::mark(void) {
@@ -92,6 +95,11 @@ void CodeFunction::mark(void) {
 		this->scope->mark();
 };
 
+void CodeFunction::references(GC_Visitor *visitor) {
+	Object::references(visitor);
+	visitor->visit(scope);
+};
+
 
 // CodeFunction prototype	
 CodeFunctionPrototype::CodeFunctionPrototype() {		
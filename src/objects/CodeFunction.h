@@ -63,6 +63,7 @@ struct CodeFunction : Object {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 };
 
 // Called on start. Defines null prototype & type
@@ -115,12 +115,16 @@ void Error::print() {
 		string lineno = "lineno";
 		string file   = "file";
 		string name   = "name";
+		string elided = "elided";
 		
 		VirtualObject *olineno = traceentry->get(NULL, &lineno);
 		VirtualObject *ofile   = traceentry->get(NULL, &file);
 		VirtualObject *oname   = traceentry->get(NULL, &name);
+		VirtualObject *oelided = traceentry->get(NULL, &elided);
 		
-		if (!olineno) {
+		if (oelided) 
+			printf("... %d more tail call(s)\n", objectIntValue(oelided));
+		else if (!olineno) {
 			if (oname)
 				printf("at %S()\n", objectStringValue(oname).toCharSequence());
 			else
@@ -233,6 +237,21 @@ VirtualObject *ErrorPrototype::call(Scope *scope, int argc, VirtualObject **args
 		
 		tracenode->table->put(string("name"), new String(sttemp->type == ASTESTE_UNDEFINED ? string("<anonymous>") : sttemp->tracename));
 		
+		// Frames replaced by tail calls, the latest first
+		int stored = sttemp->elided < AST_TAIL_TRACE_SIZE ? sttemp->elided : AST_TAIL_TRACE_SIZE;
+		for (int i = 1; i <= stored; ++i) {
+			int k = (sttemp->elided - i) % AST_TAIL_TRACE_SIZE;
+			Object *elidednode = new Object;
+			elidednode->table->put(string("name"),   new String(sttemp->elided_names[k]));
+			elidednode->table->put(string("lineno"), new Integer(sttemp->elided_linenos[k]));
+			stacktrace->array->push(elidednode);
+		}
+		if (sttemp->elided > stored) {
+			Object *elidednode = new Object;
+			elidednode->table->put(string("elided"), new Integer(sttemp->elided - stored));
+			stacktrace->array->push(elidednode);
+		}
+		
 		sttempprev = sttemp;
 		sttemp     = sttemp->next;
 	}
@@ -320,12 +339,16 @@ static VirtualObject* function_print(Scope *scope, int argc, VirtualObject **arg
 		string lineno = "lineno";
 		string file   = "file";
 		string name   = "name";
+		string elided = "elided";
 		
 		VirtualObject *olineno = traceentry->get(NULL, &lineno);
 		VirtualObject *ofile   = traceentry->get(NULL, &file);
 		VirtualObject *oname   = traceentry->get(NULL, &name);
+		VirtualObject *oelided = traceentry->get(NULL, &elided);
 		
-		if (!olineno) {
+		if (oelided) 
+			printf("... %d more tail call(s)\n", objectIntValue(oelided));
+		else if (!olineno) {
 			if (oname)
 				printf("at %S()\n", objectStringValue(oname).toCharSequence());
 			else
@@ -44,7 +44,8 @@ Integer::Integer(int i) {
 };
 
 VirtualObject *Integer::get(Scope *scope, string *name) {
-	return integer_prototype->table->get(*name);
+	VirtualObject *method = integer_prototype->builtins.get(name);
+	return method ? method : integer_prototype->table->get(*name);
 };
 
 void Integer::put(Scope *scope, string *name, VirtualObject *value) {};
@@ -60,29 +61,29 @@ VirtualObject *Integer::call(Scope *scope, int argc, VirtualObject **args) {
 };
 
 // Integer prototype	
-IntegerPrototype::IntegerPrototype() {		
-	// table = new TreeObjectMap;
-	type  = INTEGER_PROTOTYPE;
-};
-
 void IntegerPrototype::finalize(void) {
 	table->finalize();
 };
 
 VirtualObject *IntegerPrototype::get(Scope *scope, string *name) {
+	define();
 	return table->get(*name);
 };
 
 void IntegerPrototype::put(Scope *scope, string *name, VirtualObject *value) {
+	define();
+	builtins.override(name);
 	table->put(*name, value);
 };
 
 void IntegerPrototype::remove(Scope *scope, string *name) {
+	define();
+	builtins.override(name);
 	table->remove(*name);
 };
 
 bool IntegerPrototype::contains(Scope *scope, string *name) {
-	return table->contains(*name);
+	return builtins.get(name) || table->contains(*name);
 };
 
 VirtualObject *IntegerPrototype::call(Scope *scope, int argc, VirtualObject **args) {
@@ -96,6 +97,12 @@ void IntegerPrototype::mark(void) {
 		return;
 	gc_reachable = 1;
 	table->mark();
+	builtins.mark();
+};
+
+void IntegerPrototype::references(GC_Visitor *visitor) {
+	Object::references(visitor);
+	builtins.references(visitor);
 };
 
 // Operators
@@ -368,40 +375,76 @@ static VirtualObject* function_parseInt(Scope *scope, int argc, VirtualObject **
 };
 
 
+// Seed of builtin_slot for integer_methods
+#define INTEGER_METHODS_SEED 197
+
+// Fixed methods of integer prototype placed by builtin_slot
+static constexpr BuiltinMethod integer_methods[BUILTIN_SLOTS] = {
+	/*  0 */ BUILTIN_NONE,
+	/*  1 */ { "__operator+",   &operator_sum },
+	/*  2 */ BUILTIN_NONE, BUILTIN_NONE,
+	/*  4 */ { "__operator-x",  &operator_neg },
+	/*  5 */ BUILTIN_NONE,
+	/*  6 */ { "__operator~x",  &operator_bnot },
+	/*  7 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 10 */ { "toString",      &function_tostring },
+	/* 11 */ BUILTIN_NONE, BUILTIN_NONE,
+	/* 13 */ { "__operator/",   &operator_div },
+	/* 14 */ { "__operator&",   &operator_band },
+	/* 15 */ { "__operator<<",  &operator_div },
+	/* 16 */ BUILTIN_NONE,
+	/* 17 */ { "__operator!=",  &operator_neq },
+	/* 18 */ BUILTIN_NONE,
+	/* 19 */ { "__operator>",   &operator_gt },
+	/* 20 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 24 */ { "__operator^",   &operator_bxor },
+	/* 25 */ { "__operator||",  &operator_or },
+	/* 26 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 30 */ { "__operator|",   &operator_bor },
+	/* 31 */ BUILTIN_NONE,
+	/* 32 */ { "__operator!x",  &operator_not },
+	/* 33 */ { "__operator<",   &operator_lt },
+	/* 34 */ BUILTIN_NONE, BUILTIN_NONE,
+	/* 36 */ { "__operator%",   &operator_mod },
+	/* 37 */ { "__operator-",   &operator_sub },
+	/* 38 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 44 */ { "parseInt",      &function_parseInt },
+	/* 45 */ BUILTIN_NONE,
+	/* 46 */ { "__operator+x",  &operator_pos },
+	/* 47 */ BUILTIN_NONE,
+	// Was defined twice with operator_le last, kept as is
+	/* 48 */ { "__operator>=",  &operator_le },
+	/* 49 */ BUILTIN_NONE,
+	/* 50 */ { "__operator==",  &operator_eq },
+	/* 51 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 54 */ { "__operator*",   &operator_mul },
+	/* 55 */ { "__operator>>>", &operator_ushr },
+	/* 56 */ { "__operator++",  &operator_inc },
+	/* 57 */ { "__operator&&",  &operator_and },
+	/* 58 */ BUILTIN_NONE,
+	/* 59 */ { "__operator>>",  &operator_shr },
+	/* 60 */ BUILTIN_NONE,
+	/* 61 */ { "__operator--",  &operator_dec },
+	/* 62 */ BUILTIN_NONE, BUILTIN_NONE
+};
+
+static_assert(builtin_table_valid(integer_methods, INTEGER_METHODS_SEED), "integer_methods does not match builtin_slot");
+
+// Copies methods into the dynamic table on the first use of prototype itself
+static void define_integer_prototype(Object *proto) {
+	((IntegerPrototype*) proto)->builtins.define(proto->table);
+};
+
+IntegerPrototype::IntegerPrototype() : LazyObject(&define_integer_prototype), builtins(integer_methods, INTEGER_METHODS_SEED) {
+	// table = new TreeObjectMap;
+	type  = INTEGER_PROTOTYPE;
+};
+
 // Called on start. Defines integer prototype & type
 void define_integer(Scope *scope) {
 	integer_prototype = new IntegerPrototype();
 	scope->table->put(string("Integer"), integer_prototype);
 	
 	integer_prototype->table->put(string("__typename"),    new String("Integer"));
-	integer_prototype->table->put(string("__operator=="),  new NativeFunction(&operator_eq));
-	integer_prototype->table->put(string("__operator!="),  new NativeFunction(&operator_neq));
-	integer_prototype->table->put(string("__operator>"),   new NativeFunction(&operator_gt));
-	integer_prototype->table->put(string("__operator<"),   new NativeFunction(&operator_lt));
-	integer_prototype->table->put(string("__operator>="),  new NativeFunction(&operator_ge));
-	integer_prototype->table->put(string("__operator>="),  new NativeFunction(&operator_le));
-	integer_prototype->table->put(string("__operator+"),   new NativeFunction(&operator_sum));
-	integer_prototype->table->put(string("__operator-"),   new NativeFunction(&operator_sub));
-	integer_prototype->table->put(string("__operator*"),   new NativeFunction(&operator_mul));
-	integer_prototype->table->put(string("__operator/"),   new NativeFunction(&operator_div));
-	integer_prototype->table->put(string("__operator%"),   new NativeFunction(&operator_mod));
-	integer_prototype->table->put(string("__operator<<"),  new NativeFunction(&operator_div));
-	integer_prototype->table->put(string("__operator>>"),  new NativeFunction(&operator_shr));
-	integer_prototype->table->put(string("__operator>>>"), new NativeFunction(&operator_ushr));
-	integer_prototype->table->put(string("__operator&"),   new NativeFunction(&operator_band));
-	integer_prototype->table->put(string("__operator|"),   new NativeFunction(&operator_bor));
-	integer_prototype->table->put(string("__operator&&"),  new NativeFunction(&operator_and));
-	integer_prototype->table->put(string("__operator||"),  new NativeFunction(&operator_or));
-	integer_prototype->table->put(string("__operator^"),   new NativeFunction(&operator_bxor));
-	integer_prototype->table->put(string("__operator-x"),  new NativeFunction(&operator_neg));
-	integer_prototype->table->put(string("__operator+x"),  new NativeFunction(&operator_pos));
-	integer_prototype->table->put(string("__operator!x"),  new NativeFunction(&operator_not));
-	integer_prototype->table->put(string("__operator~x"),  new NativeFunction(&operator_bnot));
-	integer_prototype->table->put(string("__operator++"),  new NativeFunction(&operator_inc));
-	integer_prototype->table->put(string("__operator--"),  new NativeFunction(&operator_dec));
-	
-	integer_prototype->table->put(string("toString"),      new NativeFunction(&function_tostring));
-	integer_prototype->table->put(string("parseInt"),      new NativeFunction(&function_parseInt));
 	integer_prototype->table->put(string("SIZE"),          new Integer(sizeof(int)));
 };
-
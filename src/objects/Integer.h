@@ -26,12 +26,15 @@
 #include "Object.h"
 #include "Scope.h"
 #include "TreeObjectMap.h"
+#include "BuiltinTable.h"
 
 #include "../TokenNamespace.h"
 #include "../string.h"
 
 // Integer prototype's prototype	
-struct IntegerPrototype : Object {
+struct IntegerPrototype : LazyObject {
+	// Fixed methods, used before the dynamic table
+	BuiltinTable builtins;
 	IntegerPrototype();
 	void finalize(void);
 	VirtualObject *get(Scope*, string*);
@@ -40,6 +43,7 @@ struct IntegerPrototype : Object {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 };
 
 // Integer type's prototype
@@ -30,6 +30,7 @@
 
 #include "../string.h"
 #include "../FileUrl.h"
+#include "../Tracer.h"
 
 VectorArray<NativeModule> *loaded_modules = NULL;
 NativeLoader              *native_loader  = NULL;
@@ -143,10 +144,15 @@ static VirtualObject* function_load(Scope *scope, int argc, VirtualObject **args
 	
 	FileUrl relative_url = FileUrl(scope->context->script_dir_path, &url);
 	
-	if (relative_url.exists() && relative_url.isFile())
-		return new String(native_loader->loadModule(scope, string(relative_url.path), argc - 1, args + sizeof(VirtualObject*)));
+	unsigned long long start = _tracer_enabled ? tracer_now() : 0;
+	char *path               = relative_url.exists() && relative_url.isFile() ? relative_url.path : url.path;
 	
-	return new String(native_loader->loadModule(scope, string(url.path), argc - 1, args + sizeof(VirtualObject*)));
+	String *result = new String(native_loader->loadModule(scope, string(path), argc - 1, args + sizeof(VirtualObject*)));
+	
+	if (_tracer_enabled)
+		tracer_complete(TRACER_NATIVE, path, start);
+	
+	return result;
 };
 
 // amount()
@@ -78,6 +78,11 @@ void Object::mark(void) {
 	table->mark();
 };
 
+void Object::references(GC_Visitor *visitor) {
+	if (table)
+		table->references(visitor);
+};
+
 string Object::toString() {
 	if (!table)
 		return "[Object]";
@@ -93,6 +98,47 @@ double Object::toDouble() {
 };
 
 
+// Lazy object
+LazyObject::LazyObject(lazy_define_function definer) {
+	this->definer = definer;
+};
+
+VirtualObject *LazyObject::get(Scope *scope, string *name) {
+	define();
+	return Object::get(scope, name);
+};
+
+void LazyObject::put(Scope *scope, string *name, VirtualObject *value) {
+	define();
+	Object::put(scope, name, value);
+};
+
+void LazyObject::remove(Scope *scope, string *name) {
+	define();
+	Object::remove(scope, name);
+};
+
+bool LazyObject::contains(Scope *scope, string *name) {
+	define();
+	return Object::contains(scope, name);
+};
+
+VirtualObject *LazyObject::call(Scope *scope, int argc, VirtualObject **args) {
+	define();
+	return Object::call(scope, argc, args);
+};
+
+long LazyObject::toInt() {
+	define();
+	return Object::toInt();
+};
+
+double LazyObject::toDouble() {
+	define();
+	return Object::toDouble();
+};
+
+
 // Object prototype	
 ObjectPrototype::ObjectPrototype() {	
 	// printf("- - - - ObjectPrototype constructor\n");
@@ -131,6 +177,10 @@ void ObjectPrototype::mark(void) {
 	table->mark();
 };
 
+void ObjectPrototype::references(GC_Visitor *visitor) {
+	table->references(visitor);
+};
+
 
 // Operators
 
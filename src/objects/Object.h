@@ -41,6 +41,7 @@ struct ObjectPrototype : VirtualObject {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 };
 
 // Object type's prototype
@@ -55,11 +56,40 @@ struct Object : VirtualObject {//, IntCastObject, StringCastObject, DoubleCastOb
 	virtual bool contains(Scope*, string*);
 	virtual VirtualObject *call(Scope*, int, VirtualObject**);
 	virtual void mark(void);
+	virtual void references(GC_Visitor*);
 	virtual string toString();
 	virtual long toInt();
 	virtual double toDouble();
 };
 
+// Fills table of the lazy object
+typedef void (*lazy_define_function)(Object*);
+
+// Object with members defined on the first access.
+// Used for builtins, most of scripts never touch them.
+struct LazyObject : Object {
+	// NULL after members are defined
+	lazy_define_function definer;
+	LazyObject(lazy_define_function definer);
+	
+	// Defines members if not defined yet
+	inline void define() {
+		if (!definer)
+			return;
+		lazy_define_function d = definer;
+		definer = NULL;
+		d(this);
+	};
+	
+	virtual VirtualObject *get(Scope*, string*);
+	virtual void put(Scope*, string*, VirtualObject*);
+	virtual void remove(Scope*, string*);
+	virtual bool contains(Scope*, string*);
+	virtual VirtualObject *call(Scope*, int, VirtualObject**);
+	virtual long toInt();
+	virtual double toDouble();
+};
+
 // Called on start. Defines object prototype & type
 void define_object(Scope*);
 
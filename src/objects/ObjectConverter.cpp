@@ -58,6 +58,7 @@ long objectIntValue(VirtualObject *o) {
 		
 		case SCOPE:
 		case PROXY_SCOPE:
+		case CALL_SCOPE:
 			return 1;
 			
 		case INTEGER:
@@ -80,7 +81,7 @@ long objectIntValue(VirtualObject *o) {
 		}
 			
 		case OBJECT:
-			return ((Object*) o)->table->size + 1;
+			return ((Object*) o)->toInt();
 			
 		case ARRAY:
 			return ((Array*) o)->array->length + 1;
@@ -108,6 +109,7 @@ double objectDoubleValue(VirtualObject *o) {
 		
 		case SCOPE:
 		case PROXY_SCOPE:
+		case CALL_SCOPE:
 			return 1.0;
 			
 		case INTEGER:
@@ -130,7 +132,7 @@ double objectDoubleValue(VirtualObject *o) {
 		}
 			
 		case OBJECT:
-			return ((Object*) o)->table->size + 1;
+			return ((Object*) o)->toDouble();
 			
 		case ARRAY:
 			return ((Array*) o)->array->length + 1;
@@ -159,6 +161,7 @@ string objectStringValue(VirtualObject *o) {
 			return string("undefined");
 		
 		case SCOPE:
+		case CALL_SCOPE:
 			return string("[Scope]");
 		case PROXY_SCOPE:
 			return string("[ProxyScope]");
@@ -25,6 +25,8 @@
 #include "Boolean.h"
 #include "StringType.h"
 #include "NativeFunction.h"
+#include "Array.h"
+#include "CodeFunction.h"
 #include "../ASTExecuter.h"
 #include "../GarbageCollector.h"
 
@@ -55,6 +57,8 @@ Scope::Scope() {
 	parent   = NULL;
 	table    = NULL;
 	priority = 0;
+	global   = this;
+	proxied  = 0;
 };
 
 Scope::Scope(Scope *parent) {
@@ -86,7 +90,9 @@ Scope::Scope(Scope *parent, bool priority) {
 };
 
 void Scope::setParent(Scope *parent) {	
-	this->parent = parent;
+	this->parent  = parent;
+	this->global  = parent ? parent->global  : this;
+	this->proxied = parent ? parent->proxied : 0;
 	if (parent) 
 		context = parent->context;
 	if (parent)
@@ -96,6 +102,9 @@ void Scope::setParent(Scope *parent) {
 };
 
 void Scope::finalize(void) {
+	// Global cells are released
+	if (!parent)
+		++scope_version;
 	table->finalize();
 };
 
@@ -133,6 +142,8 @@ VirtualObject *Scope::get(Scope *scope, string *name) {
 // But:
 // B   -> 13
 void Scope::put(Scope *scope, string *name, VirtualObject *value) {
+	if (parent)
+		scope_shadow(name);
 	table->put(*name, value);
 };
 
@@ -165,12 +176,17 @@ void Scope::putPriority(Scope *scope, string *name, VirtualObject *value, bool p
 				o->put(scope, name, value);
 				return;
 			}
+		} else if (s->type == CALL_SCOPE) {
+			if (((CallScope*) s)->assign(scope, name, value))
+				return;
 		}		
 		
 		s = s->parent;
 	}
 	
-	table->put(*name, value);
+	if (parent)
+		scope_shadow(name);
+	define(name, value);
 };
 
 // Called whatever executer tries to define
@@ -186,6 +202,9 @@ void Scope::define(string name, VirtualObject *value) {
 };
 
 void Scope::remove(Scope *scope, string *name) {
+	// Removal may move entries of global table
+	if (!parent)
+		++scope_version;
 	if (table)
 		table->remove(*name);
 };
@@ -214,12 +233,21 @@ void Scope::mark(void) {
 	context->mark();
 };
 
+void Scope::references(GC_Visitor *visitor) {
+	visitor->visit(parent);
+	if (table)
+		table->references(visitor);
+	visitor->visit(context);
+};
+
 Scope *Scope::enclosingObject() {
 	Scope *s = this;
 	
 	while (s)
 		if (s->type == PROXY_SCOPE)
 			return s;
+		else if (s->type == CALL_SCOPE && ((CallScope*) s)->object)
+			return ((CallScope*) s)->getProxy();
 		else
 			s = s->parent;
 	
@@ -246,7 +274,9 @@ ProxyScope::ProxyScope(Scope *parent, VirtualObject *object) {
 };
 
 void ProxyScope::setParent(Scope *parent) {	
-	this->parent = parent;
+	this->parent  = parent;
+	this->global  = parent ? parent->global : this;
+	this->proxied = (parent ? parent->proxied : 0) + 1;
 	if (parent) 
 		context = parent->context;
 };
@@ -317,6 +347,12 @@ void ProxyScope::mark(void) {
 	context->mark();
 };
 
+void ProxyScope::references(GC_Visitor *visitor) {
+	visitor->visit(parent);
+	visitor->visit(object);
+	visitor->visit(context);
+};
+
 void ProxyScope::keys(Array *a) {
 	if (object)
 		if (object->type == PROXY_SCOPE)
@@ -344,6 +380,266 @@ Scope *ProxyScope::getRoot() {
 };
 
 
+// CallScope type
+static void *call_scope_pool[CALL_SCOPE_POOL_SIZE];
+static int   call_scope_pool_size = 0;
+
+void *CallScope::operator new(size_t size) {
+	if (call_scope_pool_size)
+		return gc_allocated(call_scope_pool[--call_scope_pool_size], size);
+	return gc_allocated(::operator new(size), size);
+};
+
+void CallScope::operator delete(void *ptr) {
+	if (call_scope_pool_size < CALL_SCOPE_POOL_SIZE)
+		call_scope_pool[call_scope_pool_size++] = ptr;
+	else
+		::operator delete(ptr);
+};
+
+CallScope::CallScope(CodeFunction *function, VirtualObject *object, int argc, VirtualObject **args) {
+	type            = CALL_SCOPE;
+	table           = NULL;
+	this->priority  = 0;
+	this->function  = function;
+	this->node      = function->node;
+	this->object    = object;
+	this->proxy     = NULL;
+	this->arguments = NULL;
+	this->argc      = argc;
+	this->nslots    = 0;
+	
+	for (ASTObjectList *l = node ? node->objectlist : NULL; l; l = l->next)
+		++nslots;
+	
+	if (argc + nslots <= CALL_SCOPE_INLINE_SLOTS)
+		this->args = inline_args;
+	else
+		this->args = (VirtualObject**) malloc((argc + nslots) * sizeof(VirtualObject*));
+	
+	for (int i = 0; i < argc; ++i)
+		this->args[i] = args[i];
+	for (int i = 0; i < nslots; ++i)
+		this->args[argc + i] = i < argc ? args[i] : NULL;
+	
+	setParent(function->scope);
+};
+
+void CallScope::setParent(Scope *parent) {
+	this->parent  = parent;
+	this->global  = parent ? parent->global : this;
+	this->proxied = (parent ? parent->proxied : 0) + (object ? 1 : 0);
+	if (parent) 
+		context = parent->context;
+};
+
+void CallScope::finalize(void) {
+	if (table)
+		table->finalize();
+	if (args != inline_args)
+		free(args);
+};
+
+int CallScope::slot(string *name) {
+	// Last parameter with the same name wins
+	int index = -1;
+	int i     =  0;
+	
+	for (ASTObjectList *l = node ? node->objectlist : NULL; l; l = l->next, ++i)
+		if (*(string*) l->object == *name)
+			index = i;
+	
+	return index;
+};
+
+ProxyScope *CallScope::getProxy() {
+	if (!proxy)
+		proxy = new ProxyScope(parent, object);
+	return proxy;
+};
+
+VirtualObject *CallScope::get(Scope *scope, string *name) {
+	int i = slot(name);
+	if (i != -1 && args[argc + i])
+		return args[argc + i];
+	
+	if (table) {
+		VirtualObject *v = table->get(*name);
+		if (v)
+			return v;
+	}
+	
+	if (*name == "__arguments") {
+		if (!arguments) {
+			arguments = new Array();
+			for (int i = 0; i < argc; ++i)
+				arguments->array->push(args[i]);
+		}
+		return arguments;
+	}
+	
+	if (*name == "__parent") {
+		if (object)
+			return getProxy();
+		if (parent)
+			return parent;
+		return new Null;
+	}
+	
+	if (scope_prototype) {
+		VirtualObject *v = scope_prototype->table->get(*name);
+		if (v)
+			return v;
+	}
+	
+	if (object) {
+		if (*name == "__object")
+			return object;
+		if (object->contains(scope, name))
+			return object->get(scope, name);
+	}
+	
+	if (parent != NULL) 
+		return parent->get(scope, name);
+	
+	return NULL;
+};
+
+void CallScope::put(Scope *scope, string *name, VirtualObject *value) {
+	scope_shadow(name);
+	define(name, value);
+};
+
+void CallScope::define(string *name, VirtualObject *value) {
+	int i = slot(name);
+	if (i != -1) {
+		args[argc + i] = value;
+		return;
+	}
+	
+	if (!table)
+		table = new TreeObjectMap;
+	table->put(*name, value);
+};
+
+bool CallScope::assign(Scope *scope, string *name, VirtualObject *value) {
+	int i = slot(name);
+	if (i != -1 && args[argc + i]) {
+		args[argc + i] = value;
+		return 1;
+	}
+	
+	if (table) {
+		TreeObjectMapEntry *e = table->findEntry(*name);
+		if (e) {
+			e->value = value;
+			return 1;
+		}
+	}
+	
+	// Frame-defined values are overwritten in the frame
+	if (*name == "__arguments" || *name == "__parent" || (scope_prototype && scope_prototype->table->contains(*name))) {
+		put(scope, name, value);
+		return 1;
+	}
+	
+	if (object && object->contains(scope, name)) {
+		object->put(scope, name, value);
+		return 1;
+	}
+	
+	return 0;
+};
+
+void CallScope::define(string name, VirtualObject *value) {
+	define(&name, value);
+};
+
+void CallScope::remove(Scope *scope, string *name) {
+	int i = slot(name);
+	if (i != -1)
+		args[argc + i] = NULL;
+	
+	if (table)
+		table->remove(*name);
+};
+
+bool CallScope::contains(Scope *scope, string *name) {
+	int i = slot(name);
+	if (i != -1 && args[argc + i])
+		return 1;
+	
+	if (*name == "__arguments" || *name == "__parent")
+		return 1;
+	
+	return (table && table->contains(*name)) 
+		|| (scope_prototype && scope_prototype->table->contains(*name)) 
+		|| (object && object->contains(scope, name)) 
+		|| (parent && parent->contains(scope, name));
+};
+
+VirtualObject *CallScope::call(Scope *scope, int argc, VirtualObject **args) {
+	return this;
+};
+
+void CallScope::mark(void) {
+	if (gc_reachable)
+		return;
+	gc_reachable = 1;
+	
+	if (parent && !parent->gc_reachable)
+		parent->mark();
+	
+	if (function && !function->gc_reachable)
+		function->mark();
+	
+	if (object && !object->gc_reachable)
+		object->mark();
+	
+	if (proxy && !proxy->gc_reachable)
+		proxy->mark();
+	
+	if (arguments && !arguments->gc_reachable)
+		arguments->mark();
+	
+	for (int i = 0; i < argc + nslots; ++i)
+		if (args[i] && !args[i]->gc_reachable)
+			args[i]->mark();
+	
+	if (table)
+		table->mark();
+	
+	if (context)
+		context->mark();
+};
+
+void CallScope::references(GC_Visitor *visitor) {
+	visitor->visit(parent);
+	visitor->visit(function);
+	visitor->visit(object);
+	visitor->visit(proxy);
+	visitor->visit(arguments);
+	
+	for (int i = 0; i < argc + nslots; ++i)
+		visitor->visit(args[i]);
+	
+	if (table)
+		table->references(visitor);
+	
+	visitor->visit(context);
+};
+
+void CallScope::keys(Array *a) {
+	int i = 0;
+	for (ASTObjectList *l = node ? node->objectlist : NULL; l; l = l->next, ++i)
+		if (args[argc + i])
+			a->array->push(new String(*(string*) l->object));
+	
+	if (table)
+		table->keys(a);
+};
+
+
 // Scope prototype	
 ScopePrototype::ScopePrototype() {	
 	table = new TreeObjectMap;
@@ -359,6 +655,8 @@ VirtualObject *ScopePrototype::get(Scope *scope, string *name) {
 };
 
 void ScopePrototype::put(Scope *scope, string *name, VirtualObject *value) {
+	// Prototype fields are copied into each new Scope
+	scope_shadow(name);
 	table->put(*name, value);
 }; 
 
@@ -381,6 +679,60 @@ void ScopePrototype::mark(void) {
 	table->mark();
 };
 
+void ScopePrototype::references(GC_Visitor *visitor) {
+	table->references(visitor);
+};
+
+
+// Global NAME cache
+int scope_version = 0;
+
+// Bloom filter of names, defined at runtime in non-global Scopes
+#define SCOPE_SHADOW_BITS 1024
+static unsigned int scope_shadow_bits[SCOPE_SHADOW_BITS / 32];
+
+static unsigned int scope_name_hash(string *name) {
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < name->length; ++i) {
+		h ^= (unsigned int) name->buffer[i];
+		h *= 16777619u;
+	}
+	return h % SCOPE_SHADOW_BITS;
+};
+
+void scope_shadow(string *name) {
+	unsigned int h = scope_name_hash(name);
+	
+	if (scope_shadow_bits[h / 32] & (1u << (h % 32)))
+		return;
+	
+	scope_shadow_bits[h / 32] |= 1u << (h % 32);
+	++scope_version;
+};
+
+void scope_cache(Scope *scope, string *name, VirtualObject *value, ASTNameCache *cache) {
+	cache->version = -1;
+	
+	if (!value || scope->proxied || !scope->global->table)
+		return;
+	
+	unsigned int h = scope_name_hash(name);
+	if (scope_shadow_bits[h / 32] & (1u << (h % 32)))
+		return;
+	
+	// Prototype fields are present in every Scope
+	if (scope_prototype && scope_prototype->table->contains(*name))
+		return;
+	
+	TreeObjectMapEntry *e = scope->global->table->findEntry(*name);
+	if (!e || e->value != value)
+		return;
+	
+	cache->cell    = e;
+	cache->global  = scope->global;
+	cache->version = scope_version;
+};
+
 
 // Called on start. Defines NativeFunction prototype & type
 void define_scope(Scope *scope) {
@@ -28,10 +28,13 @@
 
 #include "../TokenNamespace.h"
 #include "../string.h"
+#include "../ASTNode.h"
 #include "../ASTExecuter.h"
 #include "../GarbageCollector.h"
 
 struct Context;	
+struct ASTNode;
+struct CodeFunction;
 
 // Scope prototype's prototype
 struct ScopePrototype : VirtualObject {
@@ -44,6 +47,7 @@ struct ScopePrototype : VirtualObject {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 };
 
 // Scope type's prototype
@@ -60,6 +64,13 @@ struct Scope : VirtualObject {
 	// field of such name.
 	bool priority;
 	
+	// Root of the Scope chain, holding global variables
+	Scope     *global;
+	// Amount of Scopes in chain that resolve names through object
+	// (ProxyScope / CallScope of method). Global NAME cache 
+	// is not used while this is non-zero.
+	int       proxied;
+	
 	Scope();
 	Scope(Scope*);
 	Scope(Scope*, bool);
@@ -74,6 +85,7 @@ struct Scope : VirtualObject {
 	virtual void define(string, VirtualObject*);
 	virtual VirtualObject *call(Scope*, int, VirtualObject**);
 	virtual void mark(void);
+	virtual void references(GC_Visitor*);
 	virtual void keys(Array*);
 	
 	// Retuns closest proxy scope instance / self
@@ -99,13 +111,93 @@ struct ProxyScope : Scope {
 	void define(string, VirtualObject*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 	void keys(Array*);
 	
 	Scope *getRoot();
 };
 
+// Amount of argument slots stored inside of CallScope without malloc
+#define CALL_SCOPE_INLINE_SLOTS 8
+// Amount of released CallScope instances kept for reuse
+#define CALL_SCOPE_POOL_SIZE    256
+
+// Function call frame.
+// Stores parameters in slots instead of table, refers to the 
+// called object directly instead of allocating ProxyScope and 
+// creates __arguments Array / own table only on demand.
+// Released frames are recycled from the pool.
+struct CallScope : Scope {
+	// Called function, kept alive by the frame
+	CodeFunction *function;
+	// Called function node, contains parameter names
+	ASTNode          *node;
+	// Object, function was called on / NULL
+	VirtualObject  *object;
+	// Proxy for __parent, created on demand
+	ProxyScope      *proxy;
+	// __arguments, created on demand
+	Array       *arguments;
+	
+	int               argc;
+	int             nslots;
+	// argc passed arguments followed by nslots parameter slots.
+	// Parameter slot is NULL if argument was not passed.
+	VirtualObject   **args;
+	VirtualObject *inline_args[CALL_SCOPE_INLINE_SLOTS];
+	
+	CallScope(CodeFunction*, VirtualObject*, int, VirtualObject**);
+	void setParent(Scope*);
+	void finalize(void);
+	VirtualObject *get(Scope*, string*);
+	void put(Scope*, string*, VirtualObject*);
+	void remove(Scope*, string*);
+	bool contains(Scope*, string*);
+	void define(string*, VirtualObject*);
+	void define(string, VirtualObject*);
+	VirtualObject *call(Scope*, int, VirtualObject**);
+	void mark(void);
+	void references(GC_Visitor*);
+	void keys(Array*);
+	
+	// Replaces value of existing variable. 
+	// Returns 0 if no such variable in this frame.
+	bool assign(Scope*, string*, VirtualObject*);
+	
+	// Returns index of parameter slot by name / -1
+	int slot(string*);
+	
+	// Returns ProxyScope for the called object
+	ProxyScope *getProxy();
+	
+	static void *operator new(size_t);
+	static void operator delete(void*);
+};
+
 void define_scope(Scope *scope);
 
 extern ScopePrototype *scope_prototype;
 
+// Global NAME cache
+
+// Incremented when cached global cells may become invalid: 
+// removal from global Scope / dynamic definition of shadowing variable.
+extern int scope_version;
+
+// Called when variable is defined in non-global Scope at runtime 
+// (assignment to undeclared name / field of Scope object), 
+// disables caching of NAME nodes with such name.
+void scope_shadow(string *name);
+
+// Returns value of the NAME node from the cache / NULL if cache is invalid
+inline VirtualObject *scope_cached(Scope *scope, ASTNameCache *cache) {
+	if (cache->version == scope_version && cache->global == scope->global && !scope->proxied)
+		return cache->cell->value;
+	return NULL;
+};
+
+// Stores global cell of the name into the cache if value was 
+// resolved from the global Scope of the given scope chain.
+void scope_cache(Scope *scope, string *name, VirtualObject *value, ASTNameCache *cache);
+
 #endif
\ No newline at end of file
@@ -108,8 +108,10 @@ VirtualObject *String::get(Scope *scope, string *name) {
 		return new Undefined();
 	
 	int index = name->toInt(10, -1);
-	if (index == -1 && *name != "-1")
-		return string_prototype->table->get(*name);
+	if (index == -1 && *name != "-1") {
+		VirtualObject *method = string_prototype->builtins.get(name);
+		return method ? method : string_prototype->table->get(*name);
+	}
 	
 	if (index < 0 || index >= stringLength()) {
 		scope->context->executer->raiseError("String index out of bounds");
@@ -124,7 +126,7 @@ void String::put(Scope *scope, string *name, VirtualObject *value) {};
 void String::remove(Scope *scope, string *name) {};
 
 bool String::contains(Scope *scope, string *name) {
-	return string_prototype->table->contains(*name);
+	return string_prototype->builtins.get(name) || string_prototype->table->contains(*name);
 };
 
 VirtualObject *String::call(Scope *scope, int argc, VirtualObject **args) {
@@ -178,28 +180,29 @@ int String::stringCharAt(int index) {
 
 
 // String prototype	
-StringPrototype::StringPrototype() {		
-	// table = new TreeObjectMap;
-	type  = STRING_PROTOTYPE;
-};
-
 void StringPrototype::finalize(void) {
 	table->finalize();
 };
 
 VirtualObject *StringPrototype::get(Scope *scope, string *name) {
+	define();
 	return table->get(*name);
 };
 
 void StringPrototype::put(Scope *scope, string *name, VirtualObject *value) {
+	define();
+	builtins.override(name);
 	table->put(*name, value);
 };
 
 void StringPrototype::remove(Scope *scope, string *name) {
+	define();
+	builtins.override(name);
 	table->remove(*name);
 };
 
 bool StringPrototype::contains(Scope *scope, string *name) {
+	define();
 	return table->contains(*name);
 };
 
@@ -214,6 +217,12 @@ void StringPrototype::mark(void) {
 		return;
 	gc_reachable = 1;
 	table->mark();
+	builtins.mark();
+};
+
+void StringPrototype::references(GC_Visitor *visitor) {
+	Object::references(visitor);
+	builtins.references(visitor);
 };
 
 
@@ -1066,31 +1075,65 @@ static VirtualObject* function_tolowercase(Scope *scope, int argc, VirtualObject
 
 
 
+// Seed of builtin_slot for string_methods
+#define STRING_METHODS_SEED 13
+
+// Fixed methods of string prototype placed by builtin_slot
+static constexpr BuiltinMethod string_methods[BUILTIN_SLOTS] = {
+	/*  0 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/*  5 */ { "replace",      &function_replace },
+	/*  6 */ { "endsWith",     &function_endswith },
+	/*  7 */ BUILTIN_NONE,
+	/*  8 */ { "startsWith",   &function_startswith },
+	/*  9 */ BUILTIN_NONE,
+	/* 10 */ { "toUpperCase",  &function_touppercase },
+	/* 11 */ BUILTIN_NONE, BUILTIN_NONE,
+	/* 13 */ { "splitBy",      &function_splitby },
+	/* 14 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 18 */ { "__operator==", &operator_eq },
+	/* 19 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 23 */ { "__operator!=", &operator_neq },
+	/* 24 */ BUILTIN_NONE, BUILTIN_NONE,
+	/* 26 */ { "toLowerCase",  &function_tolowercase },
+	/* 27 */ BUILTIN_NONE,
+	/* 28 */ { "charAt",       &function_charat },
+	/* 29 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 35 */ { "contains",     &function_contains },
+	/* 36 */ BUILTIN_NONE,
+	/* 37 */ { "__operator+",  &operator_sum },
+	/* 38 */ { "length",       &function_length },
+	/* 39 */ BUILTIN_NONE,
+	/* 40 */ { "concat",       &function_concat },
+	/* 41 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 45 */ { "indexOf",      &function_indexof },
+	/* 46 */ { "trim",         &function_trim },
+	/* 47 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 52 */ { "charCodeAt",   &function_charcodeat },
+	/* 53 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE,
+	/* 56 */ { "__operator*",  &operator_mul },
+	/* 57 */ BUILTIN_NONE, BUILTIN_NONE,
+	/* 59 */ { "subString",    &function_substring },
+	/* 60 */ { "lastIndexOf",  &function_lastindexof },
+	/* 61 */ BUILTIN_NONE, BUILTIN_NONE, BUILTIN_NONE
+};
+
+static_assert(builtin_table_valid(string_methods, STRING_METHODS_SEED), "string_methods does not match builtin_slot");
+
+// Copies methods into the dynamic table on the first use of prototype itself
+static void define_string_prototype(Object *proto) {
+	((StringPrototype*) proto)->builtins.define(proto->table);
+};
+
+StringPrototype::StringPrototype() : LazyObject(&define_string_prototype), builtins(string_methods, STRING_METHODS_SEED) {
+	// table = new TreeObjectMap;
+	type  = STRING_PROTOTYPE;
+};
+
 // Called on start. Defines string prototype & type
 void define_string(Scope *scope) {
 	string_prototype = new StringPrototype();
 	scope->table->put(string("String"), string_prototype);
 	
-	string_prototype->table->put(string("__typename"),     new String("String"));
-	string_prototype->table->put(string("__operator=="),   new NativeFunction(&operator_eq));
-	string_prototype->table->put(string("__operator!="),   new NativeFunction(&operator_neq));
-	string_prototype->table->put(string("__operator+"),    new NativeFunction(&operator_sum));
-	string_prototype->table->put(string("__operator*"),    new NativeFunction(&operator_mul));
-	
-	string_prototype->table->put(string("length"),         new NativeFunction(&function_length));
-	string_prototype->table->put(string("subString"),      new NativeFunction(&function_substring));
-	string_prototype->table->put(string("charAt"),         new NativeFunction(&function_charat));
-	string_prototype->table->put(string("charCodeAt"),     new NativeFunction(&function_charcodeat));
-	string_prototype->table->put(string("startsWith"),     new NativeFunction(&function_startswith));
-	string_prototype->table->put(string("endsWith"),       new NativeFunction(&function_endswith));
-	string_prototype->table->put(string("concat"),         new NativeFunction(&function_concat));
-	string_prototype->table->put(string("replace"),        new NativeFunction(&function_replace));
-	string_prototype->table->put(string("contains"),       new NativeFunction(&function_contains));
-	string_prototype->table->put(string("indexOf"),        new NativeFunction(&function_indexof));
-	string_prototype->table->put(string("lastIndexOf"),    new NativeFunction(&function_lastindexof));
-	string_prototype->table->put(string("splitBy"),        new NativeFunction(&function_splitby));
-	string_prototype->table->put(string("trim"),           new NativeFunction(&function_trim));
-	string_prototype->table->put(string("toUpperCase"),    new NativeFunction(&function_touppercase));
-	string_prototype->table->put(string("toLowerCase"),    new NativeFunction(&function_tolowercase));
+	string_prototype->table->put(string("__typename"), new String("String"));
 };
 
@@ -27,12 +27,16 @@
 #include "Object.h"
 #include "Scope.h"
 #include "TreeObjectMap.h"
+#include "BuiltinTable.h"
 
 #include "../TokenNamespace.h"
 #include "../string.h"
 
-// String prototype's prototype	
-struct StringPrototype : Object {
+// String prototype's prototype.
+// Methods are defined on the first use.
+struct StringPrototype : LazyObject {
+	// Fixed methods, used before the dynamic table
+	BuiltinTable builtins;
 	StringPrototype();
 	void finalize(void);
 	VirtualObject *get(Scope*, string*);
@@ -41,6 +45,7 @@ struct StringPrototype : Object {
 	bool contains(Scope*, string*);
 	VirtualObject *call(Scope*, int, VirtualObject**);
 	void mark(void);
+	void references(GC_Visitor*);
 };
 
 // String type's prototype
@@ -124,7 +124,7 @@ static TreeObjectMapEntry *remove_tree(string key, TreeObjectMapEntry *t, bool *
 	// Searching for element
 	int cmp = key.compare(t->key);
 	if (cmp < 0)
-		t->left = remove_tree(key, t->right, removed);
+		t->left = remove_tree(key, t->left, removed);
 	else if (cmp > 0)
 		t->right = remove_tree(key, t->right, removed);
 	
@@ -139,11 +139,16 @@ static TreeObjectMapEntry *remove_tree(string key, TreeObjectMapEntry *t, bool *
 	
 	// With one or zero child
 	else {
-		temp = t;
+		*removed = 1;
+		temp     = t;
 		if (t->left == NULL)
 			t = t->right;
 		else if (t->right == NULL)
 			t = t->left;
+		
+		// Entry destructor deletes children
+		temp->left  = NULL;
+		temp->right = NULL;
 		delete temp;
 	}
 	
@@ -153,24 +158,24 @@ static TreeObjectMapEntry *remove_tree(string key, TreeObjectMapEntry *t, bool *
 	t->height = max(height(t->left), height(t->right)) + 1;
 	
 	// If node if unbalanced
-	// If left node is deleted, right case
+	// If right node is deleted, left case
 	if (height(t->left) - height(t->right) == 2) {
-		// right right case
-		if (height(t->left->left) - height(t->left->right) == 1)
-			return singleLeftRotate(t);
-		// right left case
+		// left left case
+		if (height(t->left->left) >= height(t->left->right))
+			return singleRightRotate(t);
+		// left right case
 		else
-			return doubleLeftRotate(t);
+			return doubleRightRotate(t);
 	}
 	
-	// If right node is deleted, left case
+	// If left node is deleted, right case
 	else if (height(t->right) - height(t->left) == 2) {
-		// left left case
-		if (height(t->right->right) - height(t->right->left) == 1)
-			return singleRightRotate(t);
 		// right right case
+		if (height(t->right->right) >= height(t->right->left))
+			return singleLeftRotate(t);
+		// right left case
 		else
-			return doubleRightRotate(t);
+			return doubleLeftRotate(t);
 	}
 	
 	return t;
@@ -424,6 +429,20 @@ void TreeObjectMap::mark(void) {
 	mark_tree(entries);
 };
 
+static void references_tree(TreeObjectMapEntry *e, GC_Visitor *visitor) {
+	if (!e)
+		return;
+	
+	visitor->visit(e->value);
+	
+	references_tree(e->left,  visitor);
+	references_tree(e->right, visitor);
+};
+
+void TreeObjectMap::references(GC_Visitor *visitor) {
+	references_tree(entries, visitor);
+};
+
 static void rec_keys(Array *a, TreeObjectMapEntry *e) {
 	if (!e)
 		return;
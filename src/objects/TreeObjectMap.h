@@ -77,6 +77,9 @@ struct TreeObjectMap {
 	// Called by handler object to mark all references
 	void mark(void);
 	
+	// Passes all values to the visitor
+	void references(GC_Visitor *visitor);
+	
 	// Called when requesting all keys 
 	// of this map as scriptable Array
 	void keys(Array *a);
@@ -39,9 +39,17 @@ static double apow(const float &x, int y) {
 	return result;
 };
 
+/* Locale of conversions is taken from environment once,
+ * setlocale() is slower than the conversion of short string
+ * and used to dominate construction of builtin names. */
+static void init_locale() {
+	static bool initialized = setlocale(LC_ALL, "") != NULL;
+	(void) initialized;
+}
+
 /* wchar_t to char */
 static char* wtoc(const wchar_t* w) {
-    setlocale(LC_ALL, "");
+	init_locale();
 	
 	int i = (int) wcstombs(NULL, w, 0);
 	
@@ -57,7 +65,7 @@ static char* wtoc(const wchar_t* w) {
 
 /* char to wchar_t */
 static wchar_t* ctow(const char* c) {
-	setlocale(LC_ALL, "");	
+	init_locale();
 	
 	int i = (int) mbstowcs(NULL, c, 0);
 	
@@ -153,6 +161,26 @@ string::string(const wchar_t *data) {
 		buffer[i] = data[i];
 };
 
+string::string(const wchar_t *data, int length) {
+	if (data == NULL || length <= 0) { 
+		buffer       = NULL;
+		size         = 0;
+		this->length = 0;
+		return;
+	}
+	
+	this->length = length;
+	
+	// size = 2^k
+	size    = 1;
+	while (length > size)
+		size <<= 2;
+	
+	buffer = (wchar_t*) calloc(size, sizeof(wchar_t));
+	for (int i = 0; i < length; i++)
+		buffer[i] = data[i];
+};
+
 string::string(string *str) {
 	if (str == NULL) {
 		buffer = NULL;
@@ -2087,7 +2115,7 @@ string string::toString(long long l, int b) {
 
 string string::toString(double d) {
 	char buffer [64];
-	sprintf(buffer, "%d", d);
+	sprintf(buffer, "%.15g", d);
 	
 	string s(buffer);
 	
@@ -44,6 +44,9 @@ struct string {
 	
 	string(const wchar_t *data);
 	
+	// Copies length chars of data
+	string(const wchar_t *data, int length);
+	
 	string(string *str);
 	
 	string(const string &str);
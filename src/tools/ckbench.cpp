@@ -0,0 +1,268 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Benchmark runner for scripts in bench/.
+ * Use:
+ * ckbench [--ck=bin/ck] [--runs=N] [--warmup=N] [--json=file] [--label=name] script.ck ...
+ * 
+ * Each script is started as separate ck process warmup + runs times,
+ * wall time & peak RSS of the timed runs are taken from wait4().
+ * Prints median / p95 / min time & peak RSS per script, JSON
+ * output can be kept per commit to track regressions.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+// Default amount of timed runs
+#define CKBENCH_RUNS   10
+// Default amount of warmup runs
+#define CKBENCH_WARMUP 2
+
+struct BenchResult {
+	const char     *script;
+	const char       *name;
+	double        *samples;
+	int                runs;
+	double           median;
+	double              p95;
+	double              min;
+	double              max;
+	double             mean;
+	long           peak_rss;
+	// Amount of runs exited with non-zero status or by signal
+	int              failed;
+};
+
+static const char *optionValue(const char *arg, const char *name) {
+	int length = strlen(name);
+	if (strncmp(arg, name, length) || arg[length] != '=')
+		return NULL;
+	return arg + length + 1;
+};
+
+static double now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+};
+
+// Runs ck -f script with output discarded.
+// Returns 1 on success, stores time in ms & max RSS in KB.
+static bool runScript(const char *ck, const char *script, double *time, long *rss) {
+	double start = now();
+	
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 0;
+	}
+	
+	if (pid == 0) {
+		int null = open("/dev/null", O_WRONLY);
+		if (null >= 0) {
+			dup2(null, 1);
+			dup2(null, 2);
+			close(null);
+		}
+		execl(ck, ck, "-f", script, (char*) NULL);
+		_exit(127);
+	}
+	
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) < 0) {
+		perror("wait4");
+		return 0;
+	}
+	
+	*time = now() - start;
+	*rss  = usage.ru_maxrss;
+	
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+};
+
+static int compareDoubles(const void *a, const void *b) {
+	double x = *(double*) a;
+	double y = *(double*) b;
+	return x < y ? -1 : x > y;
+};
+
+// Nearest-rank percentile of sorted samples
+static double percentile(double *sorted, int n, int p) {
+	int rank = (p * n + 99) / 100;
+	if (rank < 1)
+		rank = 1;
+	return sorted[rank - 1];
+};
+
+// Script name without directory & extension
+static const char *baseName(const char *path) {
+	const char *slash = strrchr(path, '/');
+	char *name = strdup(slash ? slash + 1 : path);
+	char *dot  = strrchr(name, '.');
+	if (dot && dot != name)
+		*dot = 0;
+	return name;
+};
+
+static void bench(const char *ck, const char *script, int runs, int warmup, BenchResult *r) {
+	r->script   = script;
+	r->name     = baseName(script);
+	r->runs     = runs;
+	r->samples  = (double*) malloc(runs * sizeof(double));
+	r->peak_rss = 0;
+	r->failed   = 0;
+	
+	double time;
+	long   rss;
+	
+	for (int i = 0; i < warmup; ++i)
+		if (!runScript(ck, script, &time, &rss))
+			++r->failed;
+	
+	for (int i = 0; i < runs; ++i) {
+		if (!runScript(ck, script, &time, &rss))
+			++r->failed;
+		
+		r->samples[i] = time;
+		if (rss > r->peak_rss)
+			r->peak_rss = rss;
+	}
+	
+	double *sorted = (double*) malloc(runs * sizeof(double));
+	memcpy(sorted, r->samples, runs * sizeof(double));
+	qsort(sorted, runs, sizeof(double), compareDoubles);
+	
+	r->min    = sorted[0];
+	r->max    = sorted[runs - 1];
+	r->median = runs % 2 ? sorted[runs / 2] : (sorted[runs / 2 - 1] + sorted[runs / 2]) / 2;
+	r->p95    = percentile(sorted, runs, 95);
+	r->mean   = 0;
+	for (int i = 0; i < runs; ++i)
+		r->mean += sorted[i];
+	r->mean /= runs;
+	
+	free(sorted);
+};
+
+static void jsonString(FILE *out, const char *s) {
+	fputc('"', out);
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', out);
+		fputc(*s, out);
+	}
+	fputc('"', out);
+};
+
+static void writeJSON(FILE *out, const char *label, const char *ck, int runs, int warmup, BenchResult *results, int count) {
+	fprintf(out, "{\n\t\"label\": ");
+	jsonString(out, label);
+	fprintf(out, ",\n\t\"ck\": ");
+	jsonString(out, ck);
+	fprintf(out, ",\n\t\"timestamp\": %ld,\n\t\"runs\": %d,\n\t\"warmup\": %d,\n\t\"benchmarks\": [", (long) ::time(NULL), runs, warmup);
+	
+	for (int i = 0; i < count; ++i) {
+		BenchResult *r = &results[i];
+		fprintf(out, "%s\n\t\t{\"name\": ", i ? "," : "");
+		jsonString(out, r->name);
+		fprintf(out, ", \"median_ms\": %.3f, \"p95_ms\": %.3f, \"min_ms\": %.3f, \"max_ms\": %.3f, \"mean_ms\": %.3f, \"peak_rss_kb\": %ld, \"failed\": %d, \"samples_ms\": [",
+			r->median, r->p95, r->min, r->max, r->mean, r->peak_rss, r->failed);
+		for (int j = 0; j < r->runs; ++j)
+			fprintf(out, "%s%.3f", j ? ", " : "", r->samples[j]);
+		fprintf(out, "]}");
+	}
+	
+	fprintf(out, "\n\t]\n}\n");
+};
+
+int main(int argc, char **argv) {
+	const char *ck    = "bin/ck";
+	const char *json  = NULL;
+	const char *label = "";
+	int runs          = CKBENCH_RUNS;
+	int warmup        = CKBENCH_WARMUP;
+	
+	const char **scripts = (const char**) malloc(argc * sizeof(char*));
+	int count            = 0;
+	
+	for (int i = 1; i < argc; ++i) {
+		const char *value;
+		
+		if ((value = optionValue(argv[i], "--ck")))
+			ck = value;
+		else if ((value = optionValue(argv[i], "--runs")))
+			runs = atoi(value);
+		else if ((value = optionValue(argv[i], "--warmup")))
+			warmup = atoi(value);
+		else if ((value = optionValue(argv[i], "--json")))
+			json = value;
+		else if ((value = optionValue(argv[i], "--label")))
+			label = value;
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		} else
+			scripts[count++] = argv[i];
+	}
+	
+	if (!count || runs < 1 || warmup < 0) {
+		printf("Use: %s [--ck=bin/ck] [--runs=N] [--warmup=N] [--json=file] [--label=name] script.ck ...\n", argv[0]);
+		return 1;
+	}
+	
+	if (access(ck, X_OK)) {
+		fprintf(stderr, "Can not execute %s\n", ck);
+		return 1;
+	}
+	
+	BenchResult *results = (BenchResult*) malloc(count * sizeof(BenchResult));
+	int failed           = 0;
+	
+	printf("%s, %d runs, %d warmup\n", ck, runs, warmup);
+	printf("%-16s %12s %12s %12s %14s\n", "benchmark", "median ms", "p95 ms", "min ms", "peak RSS KB");
+	
+	for (int i = 0; i < count; ++i) {
+		BenchResult *r = &results[i];
+		bench(ck, scripts[i], runs, warmup, r);
+		
+		printf("%-16s %12.2f %12.2f %12.2f %14ld%s\n", r->name, r->median, r->p95, r->min, r->peak_rss, r->failed ? "  FAILED" : "");
+		fflush(stdout);
+		
+		if (r->failed)
+			++failed;
+	}
+	
+	if (json) {
+		FILE *out = fopen(json, "w");
+		if (out) {
+			writeJSON(out, label, ck, runs, warmup, results, count);
+			fclose(out);
+		} else
+			fprintf(stderr, "Can not write %s\n", json);
+	}
+	
+	return failed ? 1 : 0;
+};
@@ -0,0 +1,302 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Offline comparison of two heap snapshots written by GC.snapshot().
+ * Use:
+ * heapdiff before.ckhs after.ckhs
+ * 
+ * Prints change of object count & bytes per type and objects
+ * of the second snapshot holding most of new objects.
+ * Objects are matched by address & type, so both snapshots 
+ * should be taken by the same process.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../HeapSnapshot.h"
+
+// Amount of rows printed in each table
+#define HEAPDIFF_TOP 20
+
+struct SnapshotType {
+	int   type;
+	char *name;
+};
+
+struct SnapshotNode {
+	unsigned long long address;
+	int                   type;
+	unsigned int         bytes;
+	unsigned int         flags;
+	unsigned int        nedges;
+	unsigned int        *edges;
+};
+
+struct Snapshot {
+	int           ntypes;
+	SnapshotType  *types;
+	int           nnodes;
+	SnapshotNode  *nodes;
+};
+
+static bool readInt(FILE *in, unsigned int *v) {
+	unsigned char b[4];
+	if (fread(b, 1, 4, in) != 4)
+		return 0;
+	*v = b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int) b[3] << 24);
+	return 1;
+};
+
+static bool readLong(FILE *in, unsigned long long *v) {
+	unsigned int lo, hi;
+	if (!readInt(in, &lo) || !readInt(in, &hi))
+		return 0;
+	*v = lo | ((unsigned long long) hi << 32);
+	return 1;
+};
+
+static bool readSnapshot(const char *path, Snapshot *s) {
+	FILE *in = fopen(path, "rb");
+	if (!in) {
+		fprintf(stderr, "Can not open %s\n", path);
+		return 0;
+	}
+	
+	unsigned int magic, version, n;
+	if (!readInt(in, &magic) || !readInt(in, &version) || magic != HEAP_SNAPSHOT_MAGIC || version != HEAP_SNAPSHOT_VERSION) {
+		fprintf(stderr, "%s is not a heap snapshot\n", path);
+		fclose(in);
+		return 0;
+	}
+	
+	bool ok = readInt(in, &n);
+	s->ntypes = ok ? n : 0;
+	s->types  = (SnapshotType*) calloc(s->ntypes + 1, sizeof(SnapshotType));
+	for (int i = 0; ok && i < s->ntypes; ++i) {
+		unsigned int type, length;
+		ok = readInt(in, &type) && readInt(in, &length) && length < 1024;
+		if (!ok)
+			break;
+		
+		s->types[i].type = (int) type;
+		s->types[i].name = (char*) calloc(length + 1, 1);
+		ok = fread(s->types[i].name, 1, length, in) == length;
+	}
+	
+	ok = ok && readInt(in, &n);
+	s->nnodes = ok ? n : 0;
+	s->nodes  = (SnapshotNode*) calloc(s->nnodes + 1, sizeof(SnapshotNode));
+	for (int i = 0; ok && i < s->nnodes; ++i) {
+		SnapshotNode *node = &s->nodes[i];
+		unsigned int type;
+		ok = readLong(in, &node->address) && readInt(in, &type) && readInt(in, &node->bytes) 
+			&& readInt(in, &node->flags) && readInt(in, &node->nedges);
+		if (!ok)
+			break;
+		
+		node->type  = (int) type;
+		node->edges = (unsigned int*) malloc((node->nedges + 1) * sizeof(unsigned int));
+		for (unsigned int j = 0; ok && j < node->nedges; ++j)
+			ok = readInt(in, &node->edges[j]) && node->edges[j] < (unsigned int) s->nnodes;
+	}
+	
+	fclose(in);
+	
+	if (!ok)
+		fprintf(stderr, "%s is truncated\n", path);
+	return ok;
+};
+
+static const char *typeName(Snapshot *s, int type) {
+	for (int i = 0; i < s->ntypes; ++i)
+		if (s->types[i].type == type)
+			return s->types[i].name;
+	return "?";
+};
+
+// address & type -> node index of snapshot, open addressing
+struct NodeIndex {
+	int *slots;
+	int   size;
+};
+
+static unsigned int nodeHash(SnapshotNode *n) {
+	unsigned long long h = n->address ^ ((unsigned long long) n->type << 48);
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9ull;
+	return (unsigned int) (h ^ (h >> 32));
+};
+
+static void buildIndex(Snapshot *s, NodeIndex *index) {
+	index->size = 16;
+	while (index->size < s->nnodes * 2)
+		index->size <<= 1;
+	index->slots = (int*) malloc(index->size * sizeof(int));
+	memset(index->slots, -1, index->size * sizeof(int));
+	
+	for (int i = 0; i < s->nnodes; ++i) {
+		unsigned int h = nodeHash(&s->nodes[i]) & (index->size - 1);
+		while (index->slots[h] >= 0)
+			h = (h + 1) & (index->size - 1);
+		index->slots[h] = i;
+	}
+};
+
+static bool contains(Snapshot *s, NodeIndex *index, SnapshotNode *n) {
+	unsigned int h = nodeHash(n) & (index->size - 1);
+	while (index->slots[h] >= 0) {
+		SnapshotNode *m = &s->nodes[index->slots[h]];
+		if (m->address == n->address && m->type == n->type)
+			return 1;
+		h = (h + 1) & (index->size - 1);
+	}
+	return 0;
+};
+
+struct TypeDelta {
+	int         type;
+	long long  count_a;
+	long long  bytes_a;
+	long long  count_b;
+	long long  bytes_b;
+};
+
+struct Holder {
+	int       node;
+	long long  held;
+	long long bytes;
+};
+
+static int compareDeltas(const void *a, const void *b) {
+	TypeDelta *x = (TypeDelta*) a;
+	TypeDelta *y = (TypeDelta*) b;
+	long long dx = x->bytes_b - x->bytes_a;
+	long long dy = y->bytes_b - y->bytes_a;
+	
+	if (dx != dy)
+		return dx < dy ? 1 : -1;
+	return (y->count_b - y->count_a) > (x->count_b - x->count_a) ? 1 : -1;
+};
+
+static int compareHolders(const void *a, const void *b) {
+	Holder *x = (Holder*) a;
+	Holder *y = (Holder*) b;
+	
+	if (x->bytes != y->bytes)
+		return x->bytes < y->bytes ? 1 : -1;
+	if (x->held != y->held)
+		return x->held < y->held ? 1 : -1;
+	return 0;
+};
+
+static TypeDelta *delta(TypeDelta *deltas, int *count, int type) {
+	for (int i = 0; i < *count; ++i)
+		if (deltas[i].type == type)
+			return &deltas[i];
+	
+	memset(&deltas[*count], 0, sizeof(TypeDelta));
+	deltas[*count].type = type;
+	return &deltas[(*count)++];
+};
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		printf("Use: %s <before> <after>\n", argv[0]);
+		return 1;
+	}
+	
+	Snapshot a, b;
+	if (!readSnapshot(argv[1], &a) || !readSnapshot(argv[2], &b))
+		return 1;
+	
+	// Per-type change
+	TypeDelta *deltas = (TypeDelta*) malloc((a.ntypes + b.ntypes + 1) * sizeof(TypeDelta));
+	int ndeltas = 0;
+	long long bytes_a = 0, bytes_b = 0;
+	
+	for (int i = 0; i < a.nnodes; ++i) {
+		TypeDelta *d = delta(deltas, &ndeltas, a.nodes[i].type);
+		++d->count_a;
+		d->bytes_a += a.nodes[i].bytes;
+		bytes_a    += a.nodes[i].bytes;
+	}
+	for (int i = 0; i < b.nnodes; ++i) {
+		TypeDelta *d = delta(deltas, &ndeltas, b.nodes[i].type);
+		++d->count_b;
+		d->bytes_b += b.nodes[i].bytes;
+		bytes_b    += b.nodes[i].bytes;
+	}
+	
+	qsort(deltas, ndeltas, sizeof(TypeDelta), compareDeltas);
+	
+	printf("Objects: %d -> %d (%+lld), bytes: %lld -> %lld (%+lld)\n\n", a.nnodes, b.nnodes, 
+		(long long) b.nnodes - a.nnodes, bytes_a, bytes_b, bytes_b - bytes_a);
+	
+	printf("%-20s %12s %12s %14s %14s\n", "type", "count", "delta", "bytes", "delta");
+	for (int i = 0; i < ndeltas; ++i) {
+		TypeDelta *d = &deltas[i];
+		const char *name = d->count_b ? typeName(&b, d->type) : typeName(&a, d->type);
+		printf("%-20s %12lld %+12lld %14lld %+14lld\n", name, d->count_b, d->count_b - d->count_a, d->bytes_b, d->bytes_b - d->bytes_a);
+	}
+	
+	// New objects of the second snapshot & old objects referring them
+	NodeIndex index;
+	buildIndex(&a, &index);
+	
+	bool *fresh = (bool*) malloc(b.nnodes + 1);
+	int nfresh  = 0;
+	for (int i = 0; i < b.nnodes; ++i)
+		if ((fresh[i] = !contains(&a, &index, &b.nodes[i])))
+			++nfresh;
+	
+	Holder *holders = (Holder*) malloc((b.nnodes + 1) * sizeof(Holder));
+	int nholders    = 0;
+	for (int i = 0; i < b.nnodes; ++i) {
+		if (fresh[i])
+			continue;
+		
+		long long held = 0, bytes = 0;
+		for (unsigned int j = 0; j < b.nodes[i].nedges; ++j)
+			if (fresh[b.nodes[i].edges[j]]) {
+				++held;
+				bytes += b.nodes[b.nodes[i].edges[j]].bytes;
+			}
+		
+		if (held) {
+			holders[nholders].node  = i;
+			holders[nholders].held  = held;
+			holders[nholders].bytes = bytes;
+			++nholders;
+		}
+	}
+	
+	qsort(holders, nholders, sizeof(Holder), compareHolders);
+	
+	printf("\nNew objects: %d, held by old objects: %d\n", nfresh, nholders);
+	printf("%-20s %18s %6s %12s %14s\n", "type", "address", "flags", "new refs", "new bytes");
+	for (int i = 0; i < nholders && i < HEAPDIFF_TOP; ++i) {
+		SnapshotNode *n = &b.nodes[holders[i].node];
+		printf("%-20s %#18llx %5s%s %12lld %14lld\n", typeName(&b, n->type), n->address, 
+			n->flags & HEAP_SNAPSHOT_ROOT ? "root" : "", n->flags & HEAP_SNAPSHOT_LOCK ? "L" : " ", 
+			holders[i].held, holders[i].bytes);
+	}
+	
+	return 0;
+};
@@ -0,0 +1,730 @@
+/*
+	Copcake script interpreter.
+    Copyright C 2018  bitrate16 bitrate16@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    at your option any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+/*
+ * Micro-benchmarks of interpreter data structures.
+ * Use:
+ * microbench [--filter=name] [--time=ms] [--json=file]
+ * 
+ * Every case is calibrated to run at least --time milliseconds,
+ * prints ns/op & amount of heap allocations per op.
+ * Allocations are counted by wrapping glibc malloc family,
+ * so string buffers, tree entries & GC chains are all included.
+ * Size is amount of map entries, vector elements, live GC objects
+ * or generated source lines, depending on the case.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "../string.h"
+#include "../VectorArray.h"
+#include "../GarbageCollector.h"
+#include "../TokenStream.h"
+#include "../Parser.h"
+#include "../FakeStream.h"
+#include "../ASTCache.h"
+#include "../Context.h"
+#include "../DefaultObjectDefineUtil.h"
+#include "../objects/TreeObjectMap.h"
+#include "../objects/Integer.h"
+#include "../objects/StringType.h"
+#include "../objects/Array.h"
+#include "../objects/NativeLoaderType.h"
+
+// Default minimal time of measured run in milliseconds
+#define MICROBENCH_TIME     200
+// Max amount of iterations of single case
+#define MICROBENCH_MAX_ITER 100000000L
+
+
+// Allocation counters
+
+static unsigned long long alloc_count = 0;
+static unsigned long long alloc_bytes = 0;
+
+#ifdef __GLIBC__
+extern "C" {
+	void *__libc_malloc(size_t);
+	void *__libc_calloc(size_t, size_t);
+	void *__libc_realloc(void*, size_t);
+	void  __libc_free(void*);
+	
+	void *malloc(size_t size) {
+		++alloc_count;
+		alloc_bytes += size;
+		return __libc_malloc(size);
+	};
+	
+	void *calloc(size_t n, size_t size) {
+		++alloc_count;
+		alloc_bytes += n * size;
+		return __libc_calloc(n, size);
+	};
+	
+	void *realloc(void *ptr, size_t size) {
+		++alloc_count;
+		alloc_bytes += size;
+		return __libc_realloc(ptr, size);
+	};
+	
+	void free(void *ptr) {
+		__libc_free(ptr);
+	};
+}
+#endif
+
+static unsigned long long now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+};
+
+// Prevents compiler from dropping computed values
+static volatile long sink;
+
+
+// Benchmark case.
+// setup() prepares state for the given size, run() performs n operations.
+
+struct MicroCase {
+	const char               *name;
+	int                       size;
+	void *(*setup)(int size);
+	void   (*run)(void *state, long n);
+	void   (*teardown)(void *state);
+};
+
+struct MicroResult {
+	const char            *name;
+	int                    size;
+	long             iterations;
+	double                   ns;
+	double               allocs;
+	double                bytes;
+};
+
+
+// TreeObjectMap
+
+struct MapState {
+	TreeObjectMap  *map;
+	string        *keys;
+	int            size;
+	Integer      *value;
+};
+
+static void *map_setup(int size) {
+	MapState *s = new MapState;
+	s->size     = size;
+	s->keys     = new string[size];
+	s->map      = new TreeObjectMap;
+	s->value    = new Integer(0);
+	GC.gc_lock(s->value);
+	
+	// Shuffled keys, tree is not balanced
+	unsigned int seed = 12345;
+	for (int i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		s->keys[i]  = string("key");
+		s->keys[i] += string::toString((int) (seed % 1000000));
+		s->keys[i] += '_';
+		s->keys[i] += string::toString(i);
+	}
+	
+	for (int i = 0; i < size; ++i)
+		s->map->put(s->keys[i], s->value);
+	return s;
+};
+
+static void map_teardown(void *state) {
+	MapState *s = (MapState*) state;
+	delete s->map;
+	delete[] s->keys;
+	GC.gc_unlock(s->value);
+	delete s;
+};
+
+// Insert into map growing up to size
+static void map_put(void *state, long n) {
+	MapState *s = (MapState*) state;
+	for (long i = 0; i < n; ++i) {
+		int k = i % s->size;
+		if (k == 0) {
+			delete s->map;
+			s->map = new TreeObjectMap;
+		}
+		s->map->put(s->keys[k], s->value);
+	}
+};
+
+static void map_get(void *state, long n) {
+	MapState *s = (MapState*) state;
+	long found  = 0;
+	for (long i = 0; i < n; ++i)
+		found += s->map->get(s->keys[i % s->size]) != NULL;
+	sink = found;
+};
+
+static void map_miss(void *state, long n) {
+	MapState *s = (MapState*) state;
+	string missing("missing-key");
+	long found  = 0;
+	for (long i = 0; i < n; ++i)
+		found += s->map->get(missing) != NULL;
+	sink = found;
+};
+
+// Remove & insert back the same key
+static void map_remove(void *state, long n) {
+	MapState *s = (MapState*) state;
+	for (long i = 0; i < n; ++i) {
+		int k = i % s->size;
+		s->map->remove(s->keys[k]);
+		s->map->put(s->keys[k], s->value);
+	}
+};
+
+
+// string
+
+static void *string_setup(int size) {
+	return NULL;
+};
+
+static void string_teardown(void *state) {};
+
+static void string_concat(void *state, long n) {
+	string a("Hello, cupcake ");
+	string b("script interpreter");
+	long length = 0;
+	for (long i = 0; i < n; ++i) {
+		string c = a + b;
+		length  += c.length;
+	}
+	sink = length;
+};
+
+// Append single character, string is reset every 1024 chars
+static void string_append(void *state, long n) {
+	string *s = new string;
+	for (long i = 0; i < n; ++i) {
+		if (s->length == 1024) {
+			delete s;
+			s = new string;
+		}
+		*s += 'x';
+	}
+	sink = s->length;
+	delete s;
+};
+
+static void string_compare(void *state, long n) {
+	string a("the quick brown fox jumps over it");
+	string b("the quick brown fox jumps over it");
+	long r = 0;
+	for (long i = 0; i < n; ++i)
+		r += a.compare(b);
+	sink = r;
+};
+
+static void string_equals(void *state, long n) {
+	string a("the quick brown fox jumps over it");
+	string b("the quick brown fox jumps over it");
+	long r = 0;
+	for (long i = 0; i < n; ++i)
+		r += a == b;
+	sink = r;
+};
+
+static void string_toint(void *state, long n) {
+	string a("1234567");
+	long r = 0;
+	for (long i = 0; i < n; ++i)
+		r += a.toInt(10, 0);
+	sink = r;
+};
+
+static void string_todouble(void *state, long n) {
+	string a("3.14159265");
+	double r = 0;
+	for (long i = 0; i < n; ++i)
+		r += a.toDouble(0);
+	sink = (long) r;
+};
+
+static void string_tostring_int(void *state, long n) {
+	long r = 0;
+	for (long i = 0; i < n; ++i)
+		r += string::toString((int) i).length;
+	sink = r;
+};
+
+static void string_tostring_double(void *state, long n) {
+	long r = 0;
+	for (long i = 0; i < n; ++i)
+		r += string::toString(i * 0.25).length;
+	sink = r;
+};
+
+
+// VectorArray
+
+static void *vector_setup(int size) {
+	return (void*) (long) size;
+};
+
+static void vector_teardown(void *state) {};
+
+// Push size elements & pop them back, op is single push or pop
+static void vector_push_pop(void *state, long n) {
+	int size = (int) (long) state;
+	VectorArray<int> *v = new VectorArray<int>;
+	int value;
+	long i = 0;
+	while (i < n) {
+		for (int k = 0; k < size && i < n; ++k, ++i)
+			v->push(&value);
+		while (v->length && i < n) {
+			v->pop();
+			++i;
+		}
+	}
+	sink = v->length;
+	delete v;
+};
+
+
+// GarbageCollector
+
+struct HeapState {
+	Array *root;
+	int    size;
+};
+
+// Heap of size live objects reachable from single root
+static void *heap_setup(int size) {
+	HeapState *s = new HeapState;
+	s->size      = size;
+	s->root      = new Array;
+	GC.gc_attach_root(s->root);
+	for (int i = 0; i < size; ++i)
+		s->root->array->push(new Integer(i));
+	return s;
+};
+
+static void heap_teardown(void *state) {
+	HeapState *s = (HeapState*) state;
+	GC.gc_deattach_root(s->root);
+	GC.gc_collect();
+	delete s;
+};
+
+// Allocate & attach object, garbage is collected every 1024 objects
+static void gc_attach(void *state, long n) {
+	for (long i = 0; i < n; ++i) {
+		new Integer(i);
+		if (i % 1024 == 1023)
+			GC.gc_collect();
+	}
+	GC.gc_collect();
+};
+
+// Full collection with size live objects
+static void gc_collect(void *state, long n) {
+	for (long i = 0; i < n; ++i)
+		GC.gc_collect();
+};
+
+// Collection of size garbage objects next to size live objects,
+// op is single garbage object
+static void gc_sweep(void *state, long n) {
+	HeapState *s = (HeapState*) state;
+	long i = 0;
+	while (i < n) {
+		for (int k = 0; k < s->size && i < n; ++k, ++i)
+			new Integer(k);
+		GC.gc_collect();
+	}
+};
+
+
+// TokenStream & Parser
+
+// Generated source of size functions, one function per line
+static char *source_code(int size) {
+	string *source = new string;
+	for (int i = 0; i < size; ++i) {
+		*source += "var f";
+		*source += string::toString(i);
+		*source += " = function(a, b) { var s = 0; for (var i = 0; i < a; i++) s = s + i * b; ";
+		*source += "if (s > 100 && b != 0) s = s / 2.5; var r = {x: s, y: 'line ";
+		*source += string::toString(i);
+		*source += "', z: [a, b, s]}; return r; };\n";
+	}
+	
+	char *code = source->toCString();
+	delete source;
+	return code;
+};
+
+static void *source_setup(int size) {
+	char *code = source_code(size);
+	FAKESTREAM *stream = new FAKESTREAM(code);
+	free(code);
+	return stream;
+};
+
+static void source_teardown(void *state) {
+	delete (FAKESTREAM*) state;
+};
+
+static void rewind(FAKESTREAM *stream) {
+	stream->cursor = 0;
+	stream->eof_   = 0;
+};
+
+// Tokenize whole source, op is single pass
+static void tokenize(void *state, long n) {
+	FAKESTREAM *stream = (FAKESTREAM*) state;
+	long tokens = 0;
+	for (long i = 0; i < n; ++i) {
+		rewind(stream);
+		TokenStream ts;
+		ts.init(stream);
+		while (ts.nextToken())
+			++tokens;
+	}
+	sink = tokens;
+};
+
+// Parse whole source & delete tree, op is single pass
+static void parse(void *state, long n) {
+	FAKESTREAM *stream = (FAKESTREAM*) state;
+	for (long i = 0; i < n; ++i) {
+		rewind(stream);
+		TokenStream ts;
+		Parser parser;
+		ts.init(stream);
+		parser.init(&ts);
+		ASTNode *root = parser.parse();
+		sink = root != NULL;
+		delete root;
+	}
+};
+
+// Generated source written into temporary file
+static void *file_setup(int size) {
+	char *path = strdup("/tmp/microbench-XXXXXX");
+	int fd     = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Can not create %s\n", path);
+		exit(1);
+	}
+	
+	char *code = source_code(size);
+	FILE *f    = fdopen(fd, "w");
+	fputs(code, f);
+	fclose(f);
+	free(code);
+	return path;
+};
+
+static void file_teardown(void *state) {
+	unlink((char*) state);
+	free(state);
+};
+
+// Open & decode whole file, op is single load
+static void load(void *state, long n) {
+	long chars = 0;
+	for (long i = 0; i < n; ++i) {
+		FAKESTREAM stream(fopen((char*) state, "r"));
+		chars += stream.length;
+	}
+	sink = chars;
+};
+
+
+// Generated source file with tree stored in temporary cache directory
+static void *cache_setup(int size) {
+	char *dir = strdup("/tmp/microbench-cache-XXXXXX");
+	if (!mkdtemp(dir)) {
+		fprintf(stderr, "Can not create %s\n", dir);
+		exit(1);
+	}
+	_ast_cache_dir = dir;
+	
+	char *path = (char*) file_setup(size);
+	
+	FAKESTREAM stream(fopen(path, "r"));
+	TokenStream ts;
+	Parser parser;
+	ts.init(&stream);
+	parser.init(&ts);
+	ASTNode *root = parser.parse();
+	ast_cache_store(path, stream.string, stream.length, root);
+	delete root;
+	return path;
+};
+
+static void cache_teardown(void *state) {
+	DIR *dir = opendir(_ast_cache_dir);
+	if (dir) {
+		char path[1024];
+		for (struct dirent *e = readdir(dir); e; e = readdir(dir))
+			if (e->d_name[0] != '.') {
+				snprintf(path, sizeof(path), "%s/%s", _ast_cache_dir, e->d_name);
+				unlink(path);
+			}
+		closedir(dir);
+	}
+	rmdir(_ast_cache_dir);
+	
+	free((char*) _ast_cache_dir);
+	_ast_cache_dir = NULL;
+	file_teardown(state);
+};
+
+// Open & decode file, load it's tree from cache, op is single load
+static void cache_load(void *state, long n) {
+	for (long i = 0; i < n; ++i) {
+		FAKESTREAM stream(fopen((char*) state, "r"));
+		ASTNode *root = ast_cache_load((char*) state, stream.string, stream.length);
+		if (!root) {
+			fprintf(stderr, "Cache miss\n");
+			exit(1);
+		}
+		delete root;
+	}
+};
+
+
+// Builtin types & global objects
+
+// New scope with all builtins as created on startup
+static Scope *global_scope() {
+	Context *context = new Context();
+	Scope *scope     = new Scope(NULL);
+	scope->context   = context;
+	context->scope   = scope;
+	GC.gc_attach_root(scope);
+	defineTypes(scope);
+	return scope;
+};
+
+// State is pointer to the current global scope
+static void *scope_setup(int size) {
+	Scope **s = new Scope*;
+	*s = global_scope();
+	return s;
+};
+
+// Last scope stays attached, builtin prototypes belong to it
+static void scope_teardown(void *state) {
+	GC.gc_collect();
+	delete (Scope**) state;
+};
+
+// Define all builtins, op is single global scope
+static void define_types(void *state, long n) {
+	Scope **scope = (Scope**) state;
+	
+	for (long i = 0; i < n; ++i) {
+		// NativeLoader is single per process
+		unload_loaded_modules();
+		native_loader = NULL;
+		
+		// Previous prototypes are used by the new scope till it's defined
+		Scope *next = global_scope();
+		GC.gc_deattach_root(*scope);
+		*scope = next;
+		
+		if (i % 64 == 63)
+			GC.gc_collect();
+	}
+};
+
+// Method lookup on builtin values, op is single get
+static void method_get(void *state, long n) {
+	Scope *scope = *(Scope**) state;
+	
+	static const char *names[] = { "charAt", "length", "indexOf", "__operator+", "toString", "__operator==" };
+	string keys[6];
+	for (int i = 0; i < 6; ++i)
+		keys[i] = string(names[i]);
+	
+	String  str("value");
+	Integer num(42);
+	
+	for (long i = 0; i < n; ++i) {
+		int k = i % 6;
+		sink += (long) (k < 3 ? str.get(scope, &keys[k]) : num.get(scope, &keys[k]));
+	}
+};
+
+
+static MicroCase cases[] = {
+	{ "map.put",            8,     map_setup,    map_put,                map_teardown    },
+	{ "map.put",            64,    map_setup,    map_put,                map_teardown    },
+	{ "map.put",            1024,  map_setup,    map_put,                map_teardown    },
+	{ "map.put",            16384, map_setup,    map_put,                map_teardown    },
+	{ "map.get",            8,     map_setup,    map_get,                map_teardown    },
+	{ "map.get",            64,    map_setup,    map_get,                map_teardown    },
+	{ "map.get",            1024,  map_setup,    map_get,                map_teardown    },
+	{ "map.get",            16384, map_setup,    map_get,                map_teardown    },
+	{ "map.get.miss",       1024,  map_setup,    map_miss,               map_teardown    },
+	{ "map.remove+put",     64,    map_setup,    map_remove,             map_teardown    },
+	{ "map.remove+put",     1024,  map_setup,    map_remove,             map_teardown    },
+	{ "string.concat",      0,     string_setup, string_concat,          string_teardown },
+	{ "string.append",      0,     string_setup, string_append,          string_teardown },
+	{ "string.compare",     0,     string_setup, string_compare,         string_teardown },
+	{ "string.equals",      0,     string_setup, string_equals,          string_teardown },
+	{ "string.toInt",       0,     string_setup, string_toint,           string_teardown },
+	{ "string.toDouble",    0,     string_setup, string_todouble,        string_teardown },
+	{ "string.toString(i)", 0,     string_setup, string_tostring_int,    string_teardown },
+	{ "string.toString(d)", 0,     string_setup, string_tostring_double, string_teardown },
+	{ "vector.push/pop",    16,    vector_setup, vector_push_pop,        vector_teardown },
+	{ "vector.push/pop",    1024,  vector_setup, vector_push_pop,        vector_teardown },
+	{ "vector.push/pop",    65536, vector_setup, vector_push_pop,        vector_teardown },
+	{ "gc.attach",          0,     heap_setup,   gc_attach,              heap_teardown   },
+	{ "gc.collect",         1024,  heap_setup,   gc_collect,             heap_teardown   },
+	{ "gc.collect",         16384, heap_setup,   gc_collect,             heap_teardown   },
+	{ "gc.collect",         65536, heap_setup,   gc_collect,             heap_teardown   },
+	{ "gc.sweep",           1024,  heap_setup,   gc_sweep,               heap_teardown   },
+	{ "gc.sweep",           16384, heap_setup,   gc_sweep,               heap_teardown   },
+	{ "source.load",        100,   file_setup,   load,                   file_teardown   },
+	{ "source.load",        1000,  file_setup,   load,                   file_teardown   },
+	{ "tokenize",           10,    source_setup, tokenize,               source_teardown },
+	{ "tokenize",           100,   source_setup, tokenize,               source_teardown },
+	{ "tokenize",           50000, source_setup, tokenize,               source_teardown },
+	{ "parse",              10,    source_setup, parse,                  source_teardown },
+	{ "parse",              100,   source_setup, parse,                  source_teardown },
+	{ "cache.load",         10,    cache_setup,  cache_load,             cache_teardown  },
+	{ "cache.load",         100,   cache_setup,  cache_load,             cache_teardown  },
+	{ "define.types",       0,     scope_setup,  define_types,           scope_teardown  },
+	{ "method.get",         0,     scope_setup,  method_get,             scope_teardown  },
+};
+
+// Runs case with growing amount of iterations until time limit is reached
+static void measure(MicroCase *c, unsigned long long min_time, MicroResult *r) {
+	void *state = c->setup(c->size);
+	
+	long n = 1;
+	unsigned long long time, allocs, bytes;
+	
+	while (1) {
+		unsigned long long count0 = alloc_count;
+		unsigned long long bytes0 = alloc_bytes;
+		unsigned long long start  = now();
+		
+		c->run(state, n);
+		
+		time   = now() - start;
+		allocs = alloc_count - count0;
+		bytes  = alloc_bytes - bytes0;
+		
+		if (time >= min_time || n >= MICROBENCH_MAX_ITER)
+			break;
+		
+		// Predict amount of iterations for the time limit
+		long next = time ? (long) ((double) n * min_time * 1.2 / time) : n * 100;
+		if (next > n * 100)
+			next = n * 100;
+		n = next > n ? next : n * 2;
+		if (n > MICROBENCH_MAX_ITER)
+			n = MICROBENCH_MAX_ITER;
+	}
+	
+	c->teardown(state);
+	
+	r->name       = c->name;
+	r->size       = c->size;
+	r->iterations = n;
+	r->ns         = (double) time / n;
+	r->allocs     = (double) allocs / n;
+	r->bytes      = (double) bytes / n;
+};
+
+static const char *optionValue(const char *arg, const char *name) {
+	int length = strlen(name);
+	if (strncmp(arg, name, length) || arg[length] != '=')
+		return NULL;
+	return arg + length + 1;
+};
+
+int main(int argc, char **argv) {
+	const char *filter = NULL;
+	const char *json   = NULL;
+	int time           = MICROBENCH_TIME;
+	
+	for (int i = 1; i < argc; ++i) {
+		const char *value;
+		
+		if ((value = optionValue(argv[i], "--filter")))
+			filter = value;
+		else if ((value = optionValue(argv[i], "--time")))
+			time = atoi(value);
+		else if ((value = optionValue(argv[i], "--json")))
+			json = value;
+		else {
+			printf("Use: %s [--filter=name] [--time=ms] [--json=file]\n", argv[0]);
+			return 1;
+		}
+	}
+	
+	int ncases = sizeof(cases) / sizeof(MicroCase);
+	MicroResult *results = (MicroResult*) malloc(ncases * sizeof(MicroResult));
+	int count = 0;
+	
+#ifndef __GLIBC__
+	printf("Allocation counting is not supported on this platform\n");
+#endif
+	printf("%-20s %8s %12s %12s %10s %12s\n", "case", "size", "iterations", "ns/op", "allocs/op", "bytes/op");
+	
+	for (int i = 0; i < ncases; ++i) {
+		if (filter && !strstr(cases[i].name, filter))
+			continue;
+		
+		MicroResult *r = &results[count++];
+		measure(&cases[i], time * 1000000ull, r);
+		
+		printf("%-20s %8d %12ld %12.1f %10.2f %12.1f\n", r->name, r->size, r->iterations, r->ns, r->allocs, r->bytes);
+		fflush(stdout);
+	}
+	
+	if (json) {
+		FILE *out = fopen(json, "w");
+		if (!out) {
+			fprintf(stderr, "Can not write %s\n", json);
+			return 1;
+		}
+		
+		fprintf(out, "{\n\t\"cases\": [");
+		for (int i = 0; i < count; ++i)
+			fprintf(out, "%s\n\t\t{\"name\": \"%s\", \"size\": %d, \"iterations\": %ld, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.3f}",
+				i ? "," : "", results[i].name, results[i].size, results[i].iterations, results[i].ns, results[i].allocs, results[i].bytes);
+		fprintf(out, "\n\t]\n}\n");
+		fclose(out);
+	}
+	
+	return 0;
+};
@@ -0,0 +1,32 @@
+// Scope of names assigned inside of blocks.
+// Run this file with:
+// ck -f tests/block_scope.ck
+// Expected output:
+// undefined
+// undefined
+// undefined
+// 7
+// 6
+// 2
+
+// Assignment to undeclared name defines it in the block Scope
+{ x = 5; }
+stdio.println(x);
+
+if (true) { z = 3; }
+stdio.println(z);
+
+for (var i = 0; i < 1; i++) { w = 9; }
+stdio.println(w);
+
+// Names declared in enclosing scopes are assigned in place
+var n = 0;
+{ n = 7; }
+stdio.println(n);
+
+var s = 0;
+for (var j = 0; j < 4; j++) { s += j; }
+stdio.println(s);
+
+var f = function(a) { { a = a + 1; } return a; };
+stdio.println(f(1));
@@ -0,0 +1,50 @@
+// Constant folding must not change results.
+// Run this file with and without folding, output must be the same:
+// ck -f tests/constant_folding.ck > folded.txt
+// ck --no-fold -f tests/constant_folding.ck > unfolded.txt
+// diff folded.txt unfolded.txt
+
+// Integer
+stdio.println(2 + 3 * 4);
+stdio.println(7 - 10);
+stdio.println(17 / 5);
+stdio.println(17 % 5);
+stdio.println(2147483647 + 1);
+stdio.println(1 / 0 == 0);
+stdio.println(5 % 0);
+stdio.println(6 & 3);
+stdio.println(6 | 3);
+stdio.println(6 ^ 3);
+stdio.println(-16 >> 2);
+stdio.println(-16 >>> 28);
+stdio.println(3 > 2);
+stdio.println(3 < 2);
+stdio.println(3 >= 3);
+stdio.println(3 == 3);
+stdio.println(3 != 3);
+stdio.println(-5);
+stdio.println(~5);
+stdio.println(!5);
+
+// Double
+stdio.println(1.5 + 2.5);
+stdio.println(1.0 / 0.0);
+stdio.println(0.5 * 4.0);
+stdio.println(3.5 - 1.25);
+stdio.println(1.5 > 1.0);
+stdio.println(-2.5);
+stdio.println(!2.5);
+
+// Boolean
+stdio.println(true && false);
+stdio.println(true || false);
+stdio.println(true == false);
+stdio.println(!true);
+
+// String
+stdio.println("con" + "cat");
+
+// Branches
+if (1) stdio.println("if 1"); else stdio.println("else 1");
+if (false) stdio.println("if false"); else stdio.println("else false");
+stdio.println(true ? "yes" : "no");
@@ -0,0 +1,24 @@
+// Stack trace of error raised after tail calls.
+// Run this file with:
+// ck -f tests/tail_call_trace.ck
+// Expected trace, as without tail calls:
+// Error: boom
+// at Error()
+// at f(13)
+// at h(17)
+// at g(21)
+// at <.../tests/tail_call_trace.ck>[24]
+
+var f = function() {
+	raise Error('boom');
+};
+
+var h = function() {
+	return f();
+};
+
+var g = function() {
+	return h();
+};
+
+g();